@@ -0,0 +1,16 @@
+#version 330 core
+in vec3 Normal;
+in vec3 FragPos;
+
+out vec4 color;
+
+uniform vec3 lightDirection;
+uniform vec3 trafficColour;
+
+void main()
+{
+    // Flat colour with ambient and diffuse from one directional light
+    vec3 norm = normalize(Normal);
+    float diff = max(dot(norm, normalize(-lightDirection)), 0.0);
+    color = vec4(trafficColour * (0.4 + 0.6 * diff), 1.0f);
+}
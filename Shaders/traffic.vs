@@ -0,0 +1,27 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 texCoords;
+layout (location = 3) in vec4 instance; // <vec3 pos (north, up, east), float track>
+
+out vec3 Normal;
+out vec3 FragPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float scale;
+
+void main()
+{
+    // Rotate about y by the negated track, as aircraft are by their negated yaw, so the nose points
+    // along the direction of travel (east is +z)
+    float c = cos(-instance.w);
+    float s = sin(-instance.w);
+    mat3 yaw = mat3(c, 0.0, -s,
+                    0.0, 1.0, 0.0,
+                    s, 0.0, c);
+    vec3 worldPos = yaw * (scale * position) + instance.xyz;
+    gl_Position = projection * view * vec4(worldPos, 1.0f);
+    FragPos = worldPos;
+    Normal = yaw * normal;
+}
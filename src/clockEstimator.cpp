@@ -0,0 +1,144 @@
+/*
+ * clockEstimator.cpp
+ */
+
+#include "clockEstimator.h"
+
+// Standard Includes
+#include <cmath>
+#include <algorithm>
+
+#define CLOCK_SNAP_ERROR		0.5			// Offset errors larger than this are corrected at once (s)
+
+
+/* Constructor */
+ClockEstimator::ClockEstimator() {
+	reset();
+}
+
+/* Functions */
+void ClockEstimator::reset() {
+	// Forget everything, e.g. after an autopilot reboot
+	offset = 0;
+	drift = 0;
+	jitter = 0;
+	numWindows = 0;
+	nextWindow = 0;
+	windowStart = 0;
+	current.localTime = 0;
+	current.delta = 0;
+	currentSum = 0;
+	currentCount = 0;
+	lastBoot = 0;
+	lastLocal = 0;
+	targetOffset = 0;
+	targetDrift = 0;
+	targetRef = 0;
+	started = false;
+}
+
+void ClockEstimator::observe(double bootTime, double localTime) {
+	// Adds one (autopilot time, local receive time) pair
+	if(started && bootTime < lastBoot - CLOCK_RESET_JUMP) {
+		reset();
+	}
+	double delta = localTime - bootTime;
+	lastBoot = bootTime;
+
+	// First sample
+	if(!started) {
+		started = true;
+		windowStart = localTime;
+		current.localTime = localTime;
+		current.delta = delta;
+		currentSum = delta;
+		currentCount = 1;
+		offset = targetOffset = delta;
+		drift = targetDrift = 0;
+		targetRef = lastLocal = localTime;
+		return;
+	}
+
+	// Window minimum
+	if(localTime - windowStart > CLOCK_WINDOW_LENGTH) {
+		closeWindow();
+		windowStart = localTime;
+		current.localTime = localTime;
+		current.delta = delta;
+		currentSum = 0;
+		currentCount = 0;
+	} else if(delta < current.delta) {
+		current.localTime = localTime;
+		current.delta = delta;
+	}
+	currentSum += delta;
+	currentCount++;
+
+	// No message can arrive before it was sent, so the estimate never sits above an observation
+	double predicted = targetOffset + targetDrift*(localTime - targetRef);
+	if(delta < predicted) {
+		targetOffset -= predicted - delta;
+	}
+}
+
+void ClockEstimator::closeWindow() {
+	// Stores the finished window's minimum and refits
+	if(currentCount > 0) {
+		jitter = currentSum/currentCount - current.delta;
+	}
+	windows[nextWindow] = current;
+	nextWindow = (nextWindow + 1) % CLOCK_WINDOW_COUNT;
+	numWindows = std::min(numWindows + 1, (size_t)CLOCK_WINDOW_COUNT);
+	fit();
+}
+
+void ClockEstimator::fit() {
+	// Least squares line through the window minima, lowered onto their envelope
+	double meanTime = 0, meanDelta = 0;
+	for(size_t i=0; i<numWindows; i++) {
+		meanTime += windows[i].localTime;
+		meanDelta += windows[i].delta;
+	}
+	meanTime /= numWindows;
+	meanDelta /= numWindows;
+	double num = 0, den = 0;
+	for(size_t i=0; i<numWindows; i++) {
+		num += (windows[i].localTime - meanTime)*(windows[i].delta - meanDelta);
+		den += (windows[i].localTime - meanTime)*(windows[i].localTime - meanTime);
+	}
+	targetDrift = (den > 0) ? num/den : 0;
+	targetRef = meanTime;
+	targetOffset = meanDelta;
+
+	// Lower the line until no window minimum is below it
+	double shift = 0;
+	for(size_t i=0; i<numWindows; i++) {
+		double line = targetOffset + targetDrift*(windows[i].localTime - targetRef);
+		shift = std::max(shift, line - windows[i].delta);
+	}
+	targetOffset -= shift;
+}
+
+bool ClockEstimator::valid() const {
+	return started;
+}
+
+double ClockEstimator::bootTime(double localTime) {
+	// Autopilot time matching a local time, with the published offset slewed towards the estimate
+	if(!started) {
+		return 0;
+	}
+	double target = targetOffset + targetDrift*(localTime - targetRef);
+	double dt = localTime - lastLocal;
+	double error = target - offset;
+	if(dt <= 0 || std::fabs(error) > CLOCK_SNAP_ERROR) {
+		// Time went backwards (replay seek) or the estimate moved a long way, no point easing in
+		offset = target;
+	} else {
+		double maxStep = CLOCK_MAX_SLEW*dt + std::fabs(targetDrift)*dt;
+		offset += std::max(-maxStep, std::min(maxStep, error));
+	}
+	drift = targetDrift;
+	lastLocal = localTime;
+	return localTime - offset;
+}
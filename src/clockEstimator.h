@@ -0,0 +1,67 @@
+/*
+ * clockEstimator.h
+ */
+
+#ifndef CLOCKESTIMATOR_H_
+#define CLOCKESTIMATOR_H_
+
+// Standard Includes
+#include <cstddef>
+
+#define CLOCK_WINDOW_LENGTH		2.0			// Local time covered by each minimum delay window (s)
+#define CLOCK_WINDOW_COUNT		16			// Windows kept for the drift fit
+#define CLOCK_MAX_SLEW			0.02		// Fastest the published offset may move (s per s), hides estimate steps
+#define CLOCK_RESET_JUMP		1.0			// Autopilot time going backwards by more than this is a reboot (s)
+
+
+/* Classes */
+// Maps local receive time to autopilot boot time for one vehicle. Every message with a boot time gives
+// localTime - bootTime = offset + transit delay, where the delay is never negative, so the smallest
+// value in each window is the best offset estimate. A least squares line through the window minima
+// gives the offset and drift, so a slow first sample or a drifting autopilot crystal no longer shifts
+// the display for the rest of the session. Used by the render thread only.
+class ClockEstimator {
+public:
+	/* Data */
+	double				offset;					// Published localTime - bootTime at lastLocal (s)
+	double				drift;					// Rate of change of the offset (s/s)
+	double				jitter;					// Mean of (delay above the minimum) in the current window (s)
+
+	/* Constructor */
+	ClockEstimator();
+
+	/* Functions */
+	void observe(double bootTime, double localTime);
+	bool valid() const;
+	double bootTime(double localTime);
+	void reset();
+
+private:
+	/* Structures */
+	struct WindowMin {
+		double			localTime;				// Local time of the minimum
+		double			delta;					// Minimum localTime - bootTime
+	};
+
+	/* Data */
+	WindowMin			windows[CLOCK_WINDOW_COUNT];
+	size_t				numWindows;
+	size_t				nextWindow;
+	double				windowStart;			// Local time the current window opened
+	WindowMin			current;				// Minimum so far in the current window
+	double				currentSum;				// Sum of deltas in the current window, for the jitter
+	size_t				currentCount;
+	double				lastBoot;
+	double				lastLocal;				// Local time the published offset applies at
+	double				targetOffset;			// Fitted offset at targetRef (s)
+	double				targetDrift;
+	double				targetRef;
+	bool				started;
+
+	/* Functions */
+	void closeWindow();
+	void fit();
+};
+
+
+#endif /* CLOCKESTIMATOR_H_ */
@@ -0,0 +1,91 @@
+/*
+ * datagramBatch.cpp
+ */
+
+#include "datagramBatch.h"
+
+// Standard Includes
+#include <cstring>
+#include <cstdio>
+
+
+/* Constructor */
+DatagramBatch::DatagramBatch() {
+	// Point each message header at its own buffer and sender address once
+	memset(headers, 0, sizeof(headers));
+	for(int i=0; i<MAV_UDP_BATCH_SIZE; i++) {
+		iovecs[i].iov_base = buffers[i];
+		iovecs[i].iov_len = MAV_UDP_BUFFER_LENGTH;
+		headers[i].msg_hdr.msg_iov = &iovecs[i];
+		headers[i].msg_hdr.msg_iovlen = 1;
+		headers[i].msg_hdr.msg_name = &senders[i];
+		kernelTimes[i] = 0;
+	}
+}
+
+/* Functions */
+bool DatagramBatch::enableTimestamps(int socketFd) {
+	// Ask the kernel to attach its receive time to every datagram
+	int enable = 1;
+	if(setsockopt(socketFd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0) {
+		perror("SO_TIMESTAMPNS");
+		return false;
+	}
+	return true;
+}
+
+int DatagramBatch::receive(int socketFd, IngestStats* stats) {
+	// Blocks until at least one datagram arrives, then takes everything queued up to the batch size
+	for(int i=0; i<MAV_UDP_BATCH_SIZE; i++) {
+		headers[i].msg_hdr.msg_namelen = sizeof(senders[i]);
+		headers[i].msg_hdr.msg_control = controls[i];
+		headers[i].msg_hdr.msg_controllen = MAV_UDP_CONTROL_LENGTH;
+		headers[i].msg_hdr.msg_flags = 0;
+	}
+	count = recvmmsg(socketFd, headers, MAV_UDP_BATCH_SIZE, MSG_WAITFORONE, NULL);
+	if(count <= 0) {
+		count = 0;
+		return -1;
+	}
+
+	// Update statistics
+	stats->syscalls.add();
+	stats->datagrams.add(count);
+	for(int i=0; i<count; i++) {
+		stats->bytes.add(headers[i].msg_len);
+		if(headers[i].msg_hdr.msg_flags & MSG_TRUNC) {
+			stats->truncated.add();
+		}
+
+		// Kernel receive timestamp
+		kernelTimes[i] = 0;
+		for(struct cmsghdr* cmsg = CMSG_FIRSTHDR(&headers[i].msg_hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&headers[i].msg_hdr, cmsg)) {
+			if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+				struct timespec stamp;
+				memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+				kernelTimes[i] = (uint64_t)stamp.tv_sec*1000000000ull + stamp.tv_nsec;
+			}
+		}
+		if(kernelTimes[i] == 0) {
+			stats->unstamped.add();
+		}
+	}
+
+	return count;
+}
+
+const uint8_t* DatagramBatch::data(int i) const {
+	return buffers[i];
+}
+
+size_t DatagramBatch::length(int i) const {
+	return headers[i].msg_len;
+}
+
+const sockaddr_in& DatagramBatch::sender(int i) const {
+	return senders[i];
+}
+
+uint64_t DatagramBatch::kernelTimeNs(int i) const {
+	return kernelTimes[i];
+}
@@ -0,0 +1,76 @@
+/*
+ * datagramBatch.h
+ */
+
+#ifndef DATAGRAMBATCH_H_
+#define DATAGRAMBATCH_H_
+
+// Standard Includes
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+// Socket Includes
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+// Project Includes
+#include "linkHealth.h"
+
+// Buffer Sizes
+#define MAV_UDP_BUFFER_LENGTH	1500	// MTU sized, holds any MAVLink v2 frame and bundled router packets
+#define MAV_UDP_BATCH_SIZE		32		// Maximum datagrams drained per recvmmsg call
+#define MAV_UDP_CONTROL_LENGTH	64		// Ancillary data per datagram, room for one SCM_TIMESTAMPNS
+
+
+/* Structures */
+// Socket level counters, written by the thread servicing the socket and readable from any thread
+struct IngestStats {
+	RelaxedCounter	datagrams;					// Datagrams received
+	RelaxedCounter	syscalls;					// recvmmsg calls that returned data
+	RelaxedCounter	bytes;						// Payload bytes received
+	RelaxedCounter	truncated;					// Datagrams larger than MAV_UDP_BUFFER_LENGTH
+	RelaxedCounter	unstamped;					// Datagrams without a kernel receive timestamp
+	// Rates, from counter deltas taken by the reader, so a silent link reads 0
+	RelaxedValue<double> datagramRate;			// (1/s)
+	RelaxedValue<double> byteRate;				// (B/s)
+	double		rateTime = -1;					// Reader only, time of the last rate update, -1 before the first
+	uint64_t	rateDatagrams = 0;
+	uint64_t	rateBytes = 0;
+	// Rate Reporting
+	double		lastReportTime = 0;
+	uint64_t	lastDatagrams = 0;
+	uint64_t	lastSyscalls = 0;
+};
+
+/* Classes */
+// Pool of MTU sized receive buffers, filled by a single recvmmsg call. With enableTimestamps each
+// datagram also carries the time the kernel received it, before any user space scheduling delay.
+class DatagramBatch {
+public:
+	/* Data */
+	int					count = 0;		// Number of datagrams held from the last receive
+
+	/* Constructor */
+	DatagramBatch();
+
+	/* Functions */
+	static bool enableTimestamps(int socketFd);
+	int receive(int socketFd, IngestStats* stats);
+	const uint8_t* data(int i) const;
+	size_t length(int i) const;
+	const sockaddr_in& sender(int i) const;
+	uint64_t kernelTimeNs(int i) const;
+
+private:
+	/* Data */
+	uint8_t				buffers[MAV_UDP_BATCH_SIZE][MAV_UDP_BUFFER_LENGTH];
+	struct mmsghdr		headers[MAV_UDP_BATCH_SIZE];
+	struct iovec		iovecs[MAV_UDP_BATCH_SIZE];
+	sockaddr_in			senders[MAV_UDP_BATCH_SIZE];
+	uint8_t				controls[MAV_UDP_BATCH_SIZE][MAV_UDP_CONTROL_LENGTH];
+	uint64_t			kernelTimes[MAV_UDP_BATCH_SIZE];	// CLOCK_REALTIME receive time (ns), 0 if not stamped
+};
+
+
+#endif /* DATAGRAMBATCH_H_ */
@@ -0,0 +1,103 @@
+/*
+ * datagramForwarder.cpp
+ */
+
+#include "datagramForwarder.h"
+
+// Standard Includes
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+
+// Socket Includes
+#include <arpa/inet.h>
+#include <unistd.h>
+
+
+/* Constructor */
+DatagramForwarder::DatagramForwarder() {
+	// Own unbound socket, so replies from the destinations don't land on the link
+	socketFd = socket(AF_INET, SOCK_DGRAM, 0);
+	if(socketFd < 0) {
+		perror("Forward socket");
+	}
+	memset(headers, 0, sizeof(headers));
+	memset(iovecs, 0, sizeof(iovecs));
+	destinations.reserve(MAV_FORWARD_MAX_DESTINATIONS);
+}
+
+DatagramForwarder::~DatagramForwarder() {
+	if(socketFd >= 0) {
+		close(socketFd);
+	}
+}
+
+/* Functions */
+bool DatagramForwarder::addDestination(std::string ipString, int port) {
+	// Adds an endpoint, before the link starts receiving
+	if(destinations.size() >= MAV_FORWARD_MAX_DESTINATIONS) {
+		printf("WARNING: At most %i forward destinations per link, ignoring %s:%i.\n",MAV_FORWARD_MAX_DESTINATIONS,ipString.c_str(),port);
+		return false;
+	}
+	ForwardDestination destination;
+	memset(&destination.address, 0, sizeof(destination.address));
+	destination.address.sin_family = AF_INET;
+	destination.address.sin_port = htons(port);
+	if(inet_pton(AF_INET, ipString.c_str(), &destination.address.sin_addr) != 1) {
+		printf("WARNING: Invalid forward address %s.\n",ipString.c_str());
+		return false;
+	}
+	destination.name = ipString + ":" + std::to_string(port);
+	destinations.push_back(destination);
+
+	// Point this destination's headers at the shared iovecs, one per batch slot
+	size_t d = destinations.size() - 1;
+	for(int i=0; i<MAV_UDP_BATCH_SIZE; i++) {
+		struct msghdr& hdr = headers[d*MAV_UDP_BATCH_SIZE + i].msg_hdr;
+		hdr.msg_name = &destinations[d].address;
+		hdr.msg_namelen = sizeof(sockaddr_in);
+		hdr.msg_iov = &iovecs[i];
+		hdr.msg_iovlen = 1;
+	}
+	return true;
+}
+
+void DatagramForwarder::forward(const DatagramBatch* batch) {
+	// Sends the batch to every destination without copying, must finish before the batch is reused
+	int count = batch->count;
+	if(count == 0 || destinations.empty() || socketFd < 0) {
+		return;
+	}
+	for(int i=0; i<count; i++) {
+		iovecs[i].iov_base = const_cast<uint8_t*>(batch->data(i));
+		iovecs[i].iov_len = batch->length(i);
+	}
+
+	// Headers are laid out destination major, only the first count of each destination's slots are used
+	for(size_t d=0; d<destinations.size(); d++) {
+		struct mmsghdr* destHeaders = &headers[d*MAV_UDP_BATCH_SIZE];
+		int offset = 0;
+		while(offset < count) {
+			int result = sendmmsg(socketFd, destHeaders + offset, count - offset, MSG_DONTWAIT);
+			if(result < 0) {
+				// Drop this datagram and carry on with the rest
+				if(errno == EINTR) {
+					continue;
+				}
+				destinations[d].dropped.add();
+				offset++;
+			} else {
+				destinations[d].sent.add(result);
+				offset += result;
+			}
+		}
+	}
+}
+
+void DatagramForwarder::report(const std::string& linkName) {
+	// Prints per destination totals
+	for(size_t d=0; d<destinations.size(); d++) {
+		printf("Socket %s: forwarded %lu to %s, %lu dropped\n",linkName.c_str(),(unsigned long)destinations[d].sent.get(),
+				destinations[d].name.c_str(),(unsigned long)destinations[d].dropped.get());
+	}
+}
@@ -0,0 +1,58 @@
+/*
+ * datagramForwarder.h
+ */
+
+#ifndef DATAGRAMFORWARDER_H_
+#define DATAGRAMFORWARDER_H_
+
+// Standard Includes
+#include <string>
+#include <vector>
+
+// Socket Includes
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+// Project Includes
+#include "datagramBatch.h"
+#include "linkHealth.h"
+
+#define MAV_FORWARD_MAX_DESTINATIONS	8		// Endpoints per link, sizes the preallocated send headers
+
+
+/* Structures */
+struct ForwardDestination {
+	std::string		name;						// ip:port, for reporting
+	sockaddr_in		address;
+	RelaxedCounter	sent;						// Datagrams handed to the kernel
+	RelaxedCounter	dropped;					// Datagrams refused (socket buffer full, unreachable)
+};
+
+/* Classes */
+// Sends each received datagram, unchanged, to a list of UDP endpoints. The send headers point straight
+// at the DatagramBatch receive buffers, so nothing is copied or re-serialised, and one non-blocking
+// sendmmsg covers a whole batch for every destination. A destination that can't keep up is dropped
+// from, never waited on.
+class DatagramForwarder {
+public:
+	/* Data */
+	std::vector<ForwardDestination> destinations;
+
+	/* Constructor */
+	DatagramForwarder();
+	~DatagramForwarder();
+
+	/* Functions */
+	bool addDestination(std::string ipString, int port);
+	void forward(const DatagramBatch* batch);
+	void report(const std::string& linkName);
+
+private:
+	/* Data */
+	int					socketFd;
+	struct mmsghdr		headers[MAV_UDP_BATCH_SIZE*MAV_FORWARD_MAX_DESTINATIONS];
+	struct iovec		iovecs[MAV_UDP_BATCH_SIZE];
+};
+
+
+#endif /* DATAGRAMFORWARDER_H_ */
@@ -0,0 +1,259 @@
+/*
+ * historyStore.cpp
+ */
+
+#include "historyStore.h"
+
+// Standard Includes
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+// System Includes
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+
+/* Structures */
+void ChunkUnmap::operator()(char* pt) {
+	munmap(pt, length);
+}
+
+
+/* Constructor */
+HistoryStore::HistoryStore(int numColumns) : file(nullptr, fclose) {
+	// A time column and three axes per vector column. Chunks start on a page boundary in the file, so
+	// they can be mapped whatever the page size.
+	this->numColumns = numColumns;
+	chunkBytes = (1 + 3*numColumns) * HISTORY_CHUNK_SAMPLES * sizeof(double);
+	size_t pageSize = sysconf(_SC_PAGESIZE);
+	chunkStride = (chunkBytes + pageSize - 1) / pageSize * pageSize;
+	firstChunk = 0;
+	first = 0;
+	last = 0;
+	retention = {0, 0};
+	fileFailed = false;
+}
+
+/* Functions */
+void HistoryStore::setRetention(historyDef retention) {
+	// Limits the samples or time span kept, in whole chunks
+	this->retention = retention;
+}
+
+void HistoryStore::setFile(std::string path) {
+	// Writes sealed chunks to path, kept after exit, rather than an unnamed temporary file
+	filePath = path;
+}
+
+void HistoryStore::push(double time, const glm::dvec3* values) {
+	// Appends a sample, sealing the open chunk when it fills
+	size_t offset = last & HISTORY_CHUNK_MASK;
+	if(offset == 0) {
+		if(!chunks.empty()) {
+			seal(chunks.back(), firstChunk + chunks.size() - 1);
+		}
+		chunks.push_back(HistoryChunk());
+		HistoryChunk& chunk = chunks.back();
+		chunk.heap = spare ? std::move(spare) : std::unique_ptr<char[]>(new char[chunkBytes]);
+		chunk.mapping = std::unique_ptr<char, ChunkUnmap>(nullptr, ChunkUnmap{chunkBytes});
+		chunk.minTime = time;
+		chunk.unreadable = false;
+	}
+	HistoryChunk& chunk = chunks.back();
+	double* columns = (double*)chunk.heap.get();
+	columns[offset] = time;
+	for(int c=0; c<numColumns; c++) {
+		for(int a=0; a<3; a++) {
+			columns[(1 + 3*c + a)*HISTORY_CHUNK_SAMPLES + offset] = values[c][a];
+		}
+	}
+	chunk.maxTime = time;
+	last++;
+	applyRetention();
+}
+
+void HistoryStore::clear() {
+	// Empties the store and its file, indices restart from zero as for a new aircraft
+	for(size_t i=0; i<chunks.size(); i++) {
+		if(chunks[i].heap && !spare) {
+			spare = std::move(chunks[i].heap);
+		}
+	}
+	chunks.clear();
+	if(file && ftruncate(fileno(file.get()), 0) != 0) {
+		printf("WARNING: Could not truncate history file: %s\n", strerror(errno));
+	}
+	firstChunk = 0;
+	first = 0;
+	last = 0;
+}
+
+size_t HistoryStore::begin() const {
+	// Absolute index of the oldest sample kept
+	return first;
+}
+
+size_t HistoryStore::end() const {
+	// One past the newest sample
+	return last;
+}
+
+size_t HistoryStore::size() const {
+	return last - first;
+}
+
+bool HistoryStore::empty() const {
+	return last == first;
+}
+
+bool HistoryStore::available(size_t i) {
+	// False if sample i is in a chunk that couldn't be read back, check before using its values
+	return chunkData(i >> HISTORY_CHUNK_SHIFT) != nullptr;
+}
+
+double HistoryStore::time(size_t i) {
+	// An unreadable chunk gives its latest time, so searches still move past it
+	const double* columns = (const double*)chunkData(i >> HISTORY_CHUNK_SHIFT);
+	if(columns == nullptr) {
+		return chunks[(i >> HISTORY_CHUNK_SHIFT) - firstChunk].maxTime;
+	}
+	return columns[i & HISTORY_CHUNK_MASK];
+}
+
+glm::dvec3 HistoryStore::value(int column, size_t i) {
+	const double* columns = (const double*)chunkData(i >> HISTORY_CHUNK_SHIFT);
+	if(columns == nullptr) {
+		return glm::dvec3(0);
+	}
+	size_t offset = i & HISTORY_CHUNK_MASK;
+	const double* axis = columns + (1 + 3*column)*HISTORY_CHUNK_SAMPLES + offset;
+	return glm::dvec3(axis[0], axis[HISTORY_CHUNK_SAMPLES], axis[2*HISTORY_CHUNK_SAMPLES]);
+}
+
+double HistoryStore::lastTime() {
+	return chunks.back().maxTime;
+}
+
+size_t HistoryStore::lowerBound(double time) {
+	// Absolute index of the first sample not before time, end() if none. The chunk time index narrows
+	// the search to one chunk, so only that chunk is paged in.
+	size_t low = 0;
+	size_t high = chunks.size();
+	while(low < high) {
+		size_t mid = low + (high - low)/2;
+		if(chunks[mid].maxTime < time) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	if(low == chunks.size()) {
+		return last;
+	}
+
+	// Search within the chunk
+	size_t chunkNumber = firstChunk + low;
+	const double* columns = (const double*)chunkData(chunkNumber);
+	size_t lowIndex = std::max(chunkNumber << HISTORY_CHUNK_SHIFT, first);
+	size_t highIndex = std::min((chunkNumber + 1) << HISTORY_CHUNK_SHIFT, last);
+	if(columns == nullptr) {
+		return lowIndex;
+	}
+	while(lowIndex < highIndex) {
+		size_t mid = lowIndex + (highIndex - lowIndex)/2;
+		if(columns[mid & HISTORY_CHUNK_MASK] < time) {
+			lowIndex = mid + 1;
+		} else {
+			highIndex = mid;
+		}
+	}
+	return lowIndex;
+}
+
+size_t HistoryStore::advance(size_t cursor, double time) {
+	// lowerBound(time), walking forward from the last result. Playback moves a sample or two per frame, so
+	// this is constant time however long the flight; seeks and clock jumps fall back to the search.
+	if(cursor < first || cursor > last || (cursor > first && this->time(cursor - 1) >= time)) {
+		// Cursor dropped by retention, or time went backwards
+		return lowerBound(time);
+	}
+	for(int step=0; step < HISTORY_CURSOR_STEPS; step++) {
+		if(cursor == last || this->time(cursor) >= time) {
+			return cursor;
+		}
+		cursor++;
+	}
+	return lowerBound(time);
+}
+
+size_t HistoryStore::chunkCount() const {
+	return chunks.size();
+}
+
+char* HistoryStore::chunkData(size_t chunkNumber) {
+	// Columns of a chunk, mapping it from the file if it isn't in memory. If it can't be mapped it is
+	// read into the heap instead, and nullptr is returned if that fails too.
+	HistoryChunk& chunk = chunks[chunkNumber - firstChunk];
+	if(chunk.heap) {
+		return chunk.heap.get();
+	}
+	if(!chunk.mapping && !chunk.unreadable) {
+		void* pt = mmap(NULL, chunkBytes, PROT_READ, MAP_SHARED, fileno(file.get()), chunkNumber*chunkStride);
+		if(pt != MAP_FAILED) {
+			chunk.mapping.reset((char*)pt);
+		} else {
+			printf("WARNING: Could not map history chunk %lu, reading it instead: %s\n", (unsigned long)chunkNumber, strerror(errno));
+			std::unique_ptr<char[]> block(new char[chunkBytes]);
+			if(pread(fileno(file.get()), block.get(), chunkBytes, chunkNumber*chunkStride) == (ssize_t)chunkBytes) {
+				chunk.heap = std::move(block);
+				return chunk.heap.get();
+			}
+			printf("WARNING: Could not read history chunk %lu, holding aircraft over it: %s\n", (unsigned long)chunkNumber, strerror(errno));
+			chunk.unreadable = true;
+		}
+	}
+	return chunk.mapping.get();
+}
+
+void HistoryStore::seal(HistoryChunk& chunk, size_t chunkNumber) {
+	// Writes a full chunk to the file and frees its heap block for the next chunk. If the file can't be
+	// written, the chunk stays in the heap.
+	if(!file && !fileFailed) {
+		file.reset(filePath.empty() ? tmpfile() : fopen(filePath.c_str(), "w+b"));
+		if(!file) {
+			printf("WARNING: Could not open history file %s, keeping history in memory: %s\n",
+					filePath.empty() ? "(temporary)" : filePath.c_str(), strerror(errno));
+			fileFailed = true;
+		}
+	}
+	if(!file) {
+		return;
+	}
+	ssize_t written = pwrite(fileno(file.get()), chunk.heap.get(), chunkBytes, chunkNumber*chunkStride);
+	if(written != (ssize_t)chunkBytes) {
+		printf("WARNING: Could not write history chunk %lu, keeping it in memory\n", (unsigned long)chunkNumber);
+		return;
+	}
+	spare = std::move(chunk.heap);
+}
+
+void HistoryStore::applyRetention() {
+	// Moves the oldest sample kept up to the retained samples and time span exactly, then drops the chunks
+	// wholly before it, so the storage held is the window plus at most one chunk. The open chunk always stays.
+	if(retention.length > 0 && last - first > retention.length) {
+		first = last - retention.length;
+	}
+	if(retention.seconds > 0) {
+		first = advance(first, chunks.back().maxTime - retention.seconds);
+	}
+	while(chunks.size() > 1 && first >= ((firstChunk + 1) << HISTORY_CHUNK_SHIFT)) {
+		if(file) {
+			// Give the disk space back
+			fallocate(fileno(file.get()), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, firstChunk*chunkStride, chunkStride);
+		}
+		chunks.pop_front();
+		firstChunk++;
+	}
+}
@@ -0,0 +1,97 @@
+/*
+ * historyStore.h
+ */
+
+#ifndef HISTORYSTORE_H_
+#define HISTORYSTORE_H_
+
+// GL Includes
+#include <glm/glm.hpp>
+
+// Standard Includes
+#include <deque>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <cstddef>
+
+// Project Includes
+#include "settings.h"
+
+#define HISTORY_CHUNK_SHIFT		12								// log2 of the samples per chunk
+#define HISTORY_CHUNK_SAMPLES	(1 << HISTORY_CHUNK_SHIFT)		// Samples per chunk
+#define HISTORY_CHUNK_MASK		(HISTORY_CHUNK_SAMPLES - 1)
+#define HISTORY_CURSOR_STEPS	8								// Samples a cursor walks forward before searching instead
+
+typedef std::unique_ptr<FILE, int(*)(FILE*)> SpillFile;
+
+
+/* Structures */
+// Unmaps a sealed chunk
+struct ChunkUnmap {
+	size_t length;
+	void operator()(char* pt);
+};
+
+// One block of HISTORY_CHUNK_SAMPLES samples. The columns are stored one after another: time, then each
+// axis of each vector column. The open chunk lives in the heap; sealed chunks live in the history file
+// and are mapped the first time they are read (or read back into the heap if mapping fails).
+struct HistoryChunk {
+	double							minTime;	// Time index, samples are in time order
+	double							maxTime;
+	std::unique_ptr<char[]>			heap;		// Open chunk, or a sealed chunk that couldn't be written out
+	std::unique_ptr<char, ChunkUnmap>	mapping;	// Sealed chunk paged in from the file
+	bool							unreadable;	// Sealed chunk that couldn't be mapped or read back
+};
+
+
+/* Classes */
+// Time series of one telemetry stream, as a time column and numColumns vector columns. Samples are
+// addressed by their absolute index (the number of samples pushed before them), so indices held by the
+// playback code stay valid as old chunks are dropped. Full chunks are written to a file, so a long flight
+// is kept at full resolution without holding it in the heap.
+class HistoryStore {
+public:
+	/* Constructor */
+	HistoryStore(int numColumns);
+
+	/* Functions */
+	void setRetention(historyDef retention);
+	void setFile(std::string path);
+	void push(double time, const glm::dvec3* values);
+	void clear();
+	size_t begin() const;
+	size_t end() const;
+	size_t size() const;
+	bool empty() const;
+	bool available(size_t i);
+	double time(size_t i);
+	glm::dvec3 value(int column, size_t i);
+	double lastTime();
+	size_t lowerBound(double time);
+	size_t advance(size_t cursor, double time);
+	size_t chunkCount() const;
+
+private:
+	/* Data */
+	int							numColumns;
+	size_t						chunkBytes;
+	size_t						chunkStride;	// File space per chunk, chunkBytes rounded up to whole pages
+	std::deque<HistoryChunk>	chunks;			// Oldest kept first, the last is open
+	size_t						firstChunk;		// Chunk number of chunks.front()
+	size_t						first;			// Absolute index of the oldest sample kept, may be inside chunks.front()
+	size_t						last;			// One past the newest
+	historyDef					retention;		// 0 length and seconds keep the whole flight
+	std::string					filePath;		// Empty for an unnamed temporary file
+	SpillFile					file;
+	bool						fileFailed;
+	std::unique_ptr<char[]>		spare;			// Heap block of the last chunk sealed, reused for the next
+
+	/* Functions */
+	char* chunkData(size_t chunk);
+	void seal(HistoryChunk& chunk, size_t chunkNumber);
+	void applyRetention();
+};
+
+
+#endif /* HISTORYSTORE_H_ */
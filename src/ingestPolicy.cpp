@@ -0,0 +1,135 @@
+/*
+ * ingestPolicy.cpp
+ */
+
+#include "ingestPolicy.h"
+
+// Standard Includes
+#include <cstdlib>
+
+
+/* Data */
+// Names accepted in ingest lines, any other message can be given by its msgid
+struct MavMessageName {
+	uint32_t	msgid;
+	const char*	name;
+};
+static const MavMessageName mavMessageNames[] = {
+	{MAVLINK_MSG_ID_HEARTBEAT, "HEARTBEAT"},
+	{MAVLINK_MSG_ID_SYS_STATUS, "SYS_STATUS"},
+	{MAVLINK_MSG_ID_SYSTEM_TIME, "SYSTEM_TIME"},
+	{MAVLINK_MSG_ID_GPS_RAW_INT, "GPS_RAW_INT"},
+	{MAVLINK_MSG_ID_ATTITUDE, "ATTITUDE"},
+	{MAVLINK_MSG_ID_GLOBAL_POSITION_INT, "GLOBAL_POSITION_INT"},
+	{MAVLINK_MSG_ID_VFR_HUD, "VFR_HUD"},
+	{MAVLINK_MSG_ID_TIMESYNC, "TIMESYNC"},
+	{MAVLINK_MSG_ID_BATTERY_STATUS, "BATTERY_STATUS"},
+};
+
+/* Functions */
+bool IngestFilter::setPolicy(std::string message, std::string policy) {
+	// Policy is "all", "latest" or a decimated rate in Hz
+	uint32_t msgid = mavMessageId(message);
+	if(msgid == UINT32_MAX) {
+		printf("WARNING: Unknown MAVLink message %s in ingest policy.\n",message.c_str());
+		return false;
+	}
+	IngestPolicy& entry = policies[msgid];
+	if(policy == "all") {
+		entry.mode = INGEST_KEEP_ALL;
+	} else if(policy == "latest") {
+		entry.mode = INGEST_LATEST;
+	} else {
+		double rate = atof(policy.c_str());
+		if(rate <= 0) {
+			printf("WARNING: Ingest policy for %s must be all, latest or a rate in Hz, not %s.\n",message.c_str(),policy.c_str());
+			policies.erase(msgid);
+			return false;
+		}
+		entry.mode = INGEST_DECIMATE;
+		entry.period = 1.0/rate;
+	}
+	return true;
+}
+
+IngestAction IngestFilter::applyPolicy(IngestPolicy& policy, const mavlink_message_t* msg, double timeReceived) {
+	// Decides what happens to one message with a policy
+	switch(policy.mode) {
+		case INGEST_LATEST: {
+			policy.accepted.add();
+			return INGEST_PUBLISH_LATEST;
+		}
+		case INGEST_DECIMATE: {
+			// Keep the first message due in each period. The schedule advances by whole periods so the
+			// kept rate doesn't drift below the target with jittery arrivals, and restarts after a gap.
+			double& due = nextDue[((uint64_t)msg->msgid << 16) | (msg->sysid << 8) | msg->compid];
+			if(timeReceived < due) {
+				policy.decimated.add();
+				return INGEST_DROP;
+			}
+			due = (timeReceived - due < policy.period) ? due + policy.period : timeReceived + policy.period;
+			policy.accepted.add();
+			return INGEST_PUBLISH;
+		}
+		default: {
+			policy.accepted.add();
+			return INGEST_PUBLISH;
+		}
+	}
+}
+
+void IngestFilter::report(const std::string& linkName) {
+	// Prints the totals of each policy
+	std::unordered_map<uint32_t, IngestPolicy>::iterator it;
+	for(it = policies.begin(); it != policies.end(); it++) {
+		const IngestPolicy& policy = it->second;
+		std::string name = (mavMessageName(it->first) != nullptr) ? mavMessageName(it->first) : "msgid " + std::to_string(it->first);
+		if(policy.mode == INGEST_DECIMATE) {
+			printf("Socket %s: %s at %.1f Hz, %lu kept, %lu decimated\n",linkName.c_str(),name.c_str(),1.0/policy.period,
+					(unsigned long)policy.accepted.get(),(unsigned long)policy.decimated.get());
+		} else if(policy.mode == INGEST_LATEST) {
+			printf("Socket %s: %s latest only, %lu published\n",linkName.c_str(),name.c_str(),(unsigned long)policy.accepted.get());
+		}
+	}
+}
+
+void IngestFilter::writeJson(FILE* file, const std::string& linkName, double currentTime) {
+	// One JSON object per line, policies are fixed once the link starts so this is safe from any thread
+	if(policies.empty()) {
+		return;
+	}
+	fprintf(file,"{\"time\":%.3f,\"link\":\"%s\",\"ingest_policies\":[",currentTime,linkName.c_str());
+	std::unordered_map<uint32_t, IngestPolicy>::iterator it;
+	for(it = policies.begin(); it != policies.end(); it++) {
+		const IngestPolicy& policy = it->second;
+		const char* mode = (policy.mode == INGEST_LATEST) ? "latest" : (policy.mode == INGEST_DECIMATE) ? "decimate" : "all";
+		fprintf(file,"%s{\"msgid\":%u,\"mode\":\"%s\",\"rate\":%.1f,\"accepted\":%lu,\"decimated\":%lu}",(it == policies.begin()) ? "" : ",",
+				it->first,mode,(policy.period > 0) ? 1.0/policy.period : 0.0,(unsigned long)policy.accepted.get(),(unsigned long)policy.decimated.get());
+	}
+	fprintf(file,"]}\n");
+}
+
+uint32_t mavMessageId(std::string message) {
+	// Msgid from a message name or number, UINT32_MAX if unknown
+	for(unsigned int i=0; i<sizeof(mavMessageNames)/sizeof(mavMessageNames[0]); i++) {
+		if(message == mavMessageNames[i].name) {
+			return mavMessageNames[i].msgid;
+		}
+	}
+	char* end;
+	unsigned long msgid = strtoul(message.c_str(), &end, 10);
+	if(message.empty() || *end != '\0' || msgid > 0xFFFFFF) {
+		return UINT32_MAX;
+	}
+	return msgid;
+}
+
+const char* mavMessageName(uint32_t msgid) {
+	// Name for reports, nullptr for messages not in the table
+	for(unsigned int i=0; i<sizeof(mavMessageNames)/sizeof(mavMessageNames[0]); i++) {
+		if(mavMessageNames[i].msgid == msgid) {
+			return mavMessageNames[i].name;
+		}
+	}
+	return nullptr;
+}
@@ -0,0 +1,82 @@
+/*
+ * ingestPolicy.h
+ */
+
+#ifndef INGESTPOLICY_H_
+#define INGESTPOLICY_H_
+
+// Standard Includes
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+// Mavlink Includes
+#include <c_library_v2/ardupilotmega/mavlink.h>
+
+// Project Includes
+#include "linkHealth.h"
+
+
+/* Structures */
+enum IngestMode : uint8_t {
+	INGEST_KEEP_ALL,						// Every sample is queued (default)
+	INGEST_LATEST,							// Only the newest sample is kept, the render thread takes it once per frame
+	INGEST_DECIMATE							// Samples are thinned to a fixed rate before decoding
+};
+
+enum IngestAction : uint8_t {
+	INGEST_PUBLISH,
+	INGEST_PUBLISH_LATEST,
+	INGEST_DROP
+};
+
+struct IngestPolicy {
+	IngestMode		mode = INGEST_KEEP_ALL;
+	double			period = 0;				// Decimation period (s)
+	RelaxedCounter	accepted;				// Messages passed on to the handler
+	RelaxedCounter	decimated;				// Messages dropped by decimation before decoding
+};
+
+/* Classes */
+// Per link, per msgid ingest policies, applied by the socket thread before a message is decoded. Links
+// without policies return straight away; the decimation schedule is kept per sysid/compid so vehicles
+// sharing a port are thinned independently.
+class IngestFilter {
+public:
+	/* Functions */
+	bool setPolicy(std::string message, std::string policy);
+
+	// Action for a message received at timeReceived
+	IngestAction admit(const mavlink_message_t* msg, double timeReceived) {
+		if(policies.empty()) {
+			return INGEST_PUBLISH;
+		}
+		std::unordered_map<uint32_t, IngestPolicy>::iterator it = policies.find(msg->msgid);
+		if(it == policies.end()) {
+			return INGEST_PUBLISH;
+		}
+		return applyPolicy(it->second, msg, timeReceived);
+	}
+
+	bool empty() const {
+		return policies.empty();
+	}
+	void report(const std::string& linkName);
+	void writeJson(FILE* file, const std::string& linkName, double currentTime);
+
+private:
+	/* Data */
+	std::unordered_map<uint32_t, IngestPolicy>	policies;		// By msgid, fixed once the link starts
+	std::unordered_map<uint64_t, double>		nextDue;		// Next decimated sample time per (msgid << 16) | (sysid << 8) | compid
+
+	/* Functions */
+	IngestAction applyPolicy(IngestPolicy& policy, const mavlink_message_t* msg, double timeReceived);
+};
+
+/* Functions */
+uint32_t mavMessageId(std::string message);
+const char* mavMessageName(uint32_t msgid);
+
+
+#endif /* INGESTPOLICY_H_ */
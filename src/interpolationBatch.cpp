@@ -0,0 +1,140 @@
+/*
+ * interpolationBatch.cpp
+ */
+
+#include "interpolationBatch.h"
+
+// Standard Includes
+#include <cmath>
+#include <algorithm>
+
+
+/* Constructor */
+InterpolationBatch::InterpolationBatch(size_t rows) {
+	// Columns, with every row holding still at the origin until loaded
+	this->rows = rows;
+	s.assign(rows, 0);
+	h.assign(rows, 1);
+	sAtt.assign(rows, 0);
+	for(int a=0; a<3; a++) {
+		p0[a].assign(rows, 0);
+		p1[a].assign(rows, 0);
+		v0[a].assign(rows, 0);
+		v1[a].assign(rows, 0);
+		position[a].assign(rows, 0);
+		velocity[a].assign(rows, 0);
+		attitude[a].assign(rows, 0);
+	}
+	for(int a=0; a<4; a++) {
+		q0[a].assign(rows, a == 0 ? 1 : 0);
+		q1[a].assign(rows, a == 0 ? 1 : 0);
+	}
+}
+
+/* Functions */
+void InterpolationBatch::setPositionSegment(size_t row, double s, double h, glm::dvec3 p0, glm::dvec3 v0, glm::dvec3 p1, glm::dvec3 v1) {
+	// Loads one aircraft's position segment
+	this->s[row] = s;
+	this->h[row] = std::max(h, INTERPOLATION_MIN_SEGMENT);
+	for(int a=0; a<3; a++) {
+		this->p0[a][row] = p0[a];
+		this->p1[a][row] = p1[a];
+		this->v0[a][row] = v0[a];
+		this->v1[a][row] = v1[a];
+	}
+}
+
+void InterpolationBatch::setAttitudeSegment(size_t row, double s, glm::dvec4 q0, glm::dvec4 q1) {
+	// Loads one aircraft's attitude segment
+	sAtt[row] = s;
+	for(int a=0; a<4; a++) {
+		this->q0[a][row] = q0[a];
+		this->q1[a][row] = q1[a];
+	}
+}
+
+void InterpolationBatch::interpolate() {
+	// Evaluates every row
+	hermitePositions();
+	slerpAttitudes();
+}
+
+void InterpolationBatch::hermitePositions() {
+	// Cubic Hermite through both ends with the reported velocities, so the path and its velocity are
+	// continuous from one segment to the next
+	for(int a=0; a<3; a++) {
+		const double* sPt = s.data();
+		const double* hPt = h.data();
+		const double* p0Pt = p0[a].data();
+		const double* p1Pt = p1[a].data();
+		const double* v0Pt = v0[a].data();
+		const double* v1Pt = v1[a].data();
+		double* posPt = position[a].data();
+		double* velPt = velocity[a].data();
+		for(size_t i=0; i<rows; i++) {
+			double t = std::min(std::max(sPt[i], 0.0), 1.0);
+			double t2 = t*t;
+			double t3 = t2*t;
+
+			// Basis functions and their derivatives
+			double h00 = 2*t3 - 3*t2 + 1;
+			double h10 = t3 - 2*t2 + t;
+			double h01 = -2*t3 + 3*t2;
+			double h11 = t3 - t2;
+			double d00 = 6*t2 - 6*t;
+			double d10 = 3*t2 - 4*t + 1;
+			double d11 = 3*t2 - 2*t;
+
+			posPt[i] = h00*p0Pt[i] + h10*hPt[i]*v0Pt[i] + h01*p1Pt[i] + h11*hPt[i]*v1Pt[i];
+			velPt[i] = d00*(p0Pt[i] - p1Pt[i])/hPt[i] + d10*v0Pt[i] + d11*v1Pt[i];
+		}
+	}
+}
+
+void InterpolationBatch::slerpAttitudes() {
+	// Spherical linear interpolation at constant angular rate, then back to Euler angles for drawing.
+	// Takes the short way round, so yaw wrapping past +-pi needs no special case.
+	for(size_t i=0; i<rows; i++) {
+		double t = std::min(std::max(sAtt[i], 0.0), 1.0);
+		double dot = q0[0][i]*q1[0][i] + q0[1][i]*q1[1][i] + q0[2][i]*q1[2][i] + q0[3][i]*q1[3][i];
+		double sign = std::copysign(1.0, dot);
+		dot = std::min(dot*sign, 1.0);
+
+		// Weights, falling back to linear for nearly equal ends
+		double theta = std::acos(dot);
+		double sinTheta = std::sin(theta);
+		bool small = sinTheta < 1e-6;
+		double divisor = small ? 1.0 : sinTheta;
+		double w0 = small ? 1.0 - t : std::sin((1.0 - t)*theta)/divisor;
+		double w1 = (small ? t : std::sin(t*theta)/divisor) * sign;
+
+		double w = w0*q0[0][i] + w1*q1[0][i];
+		double x = w0*q0[1][i] + w1*q1[1][i];
+		double y = w0*q0[2][i] + w1*q1[2][i];
+		double z = w0*q0[3][i] + w1*q1[3][i];
+		double norm = 1.0/std::sqrt(w*w + x*x + y*y + z*z);
+		w *= norm;
+		x *= norm;
+		y *= norm;
+		z *= norm;
+
+		// Roll, pitch, yaw (z-y-x)
+		attitude[0][i] = std::atan2(2*(w*x + y*z), 1 - 2*(x*x + y*y));
+		attitude[1][i] = std::asin(std::min(std::max(2*(w*y - z*x), -1.0), 1.0));
+		attitude[2][i] = std::atan2(2*(w*z + x*y), 1 - 2*(y*y + z*z));
+	}
+}
+
+glm::dvec4 eulerToQuaternion(glm::dvec3 euler) {
+	// Roll, pitch, yaw (z-y-x) to a unit quaternion (w,x,y,z)
+	double cr = cos(euler[0]/2);
+	double sr = sin(euler[0]/2);
+	double cp = cos(euler[1]/2);
+	double sp = sin(euler[1]/2);
+	double cy = cos(euler[2]/2);
+	double sy = sin(euler[2]/2);
+	return glm::dvec4(cr*cp*cy + sr*sp*sy,
+					  sr*cp*cy - cr*sp*sy,
+					  cr*sp*cy + sr*cp*sy,
+					  cr*cp*sy - sr*sp*cy);
+}
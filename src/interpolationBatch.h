@@ -0,0 +1,63 @@
+/*
+ * interpolationBatch.h
+ */
+
+#ifndef INTERPOLATIONBATCH_H_
+#define INTERPOLATIONBATCH_H_
+
+// GL Includes
+#include <glm/glm.hpp>
+
+// Standard Includes
+#include <vector>
+#include <cstddef>
+
+#define INTERPOLATION_MIN_SEGMENT	1e-6		// Shortest segment divided by (s)
+
+
+/* Classes */
+// Segments to evaluate this frame, one row per aircraft, stored as columns so the kernels run over every
+// aircraft in one pass with no branches. Each aircraft loads its row, interpolate() evaluates all rows,
+// and each aircraft takes its results back. A row that should hold still has equal ends.
+class InterpolationBatch {
+public:
+	/* Data */
+	size_t				rows;
+
+	// Position: cubic Hermite from (p0,v0) to (p1,v1), north, east, up (m, m/s)
+	std::vector<double>	s;							// Fraction of the segment to show, clamped to [0,1]
+	std::vector<double>	h;							// Segment length (s)
+	std::vector<double>	p0[3];
+	std::vector<double>	p1[3];
+	std::vector<double>	v0[3];
+	std::vector<double>	v1[3];
+
+	// Attitude: SLERP from q0 to q1, unit quaternions (w,x,y,z)
+	std::vector<double>	sAtt;
+	std::vector<double>	q0[4];
+	std::vector<double>	q1[4];
+
+	// Results
+	std::vector<double>	position[3];
+	std::vector<double>	velocity[3];
+	std::vector<double>	attitude[3];				// roll, pitch, yaw (rad)
+
+	/* Constructor */
+	InterpolationBatch(size_t rows);
+
+	/* Functions */
+	void setPositionSegment(size_t row, double s, double h, glm::dvec3 p0, glm::dvec3 v0, glm::dvec3 p1, glm::dvec3 v1);
+	void setAttitudeSegment(size_t row, double s, glm::dvec4 q0, glm::dvec4 q1);
+	void interpolate();
+
+private:
+	/* Functions */
+	void hermitePositions();
+	void slerpAttitudes();
+};
+
+/* Functions */
+glm::dvec4 eulerToQuaternion(glm::dvec3 euler);
+
+
+#endif /* INTERPOLATIONBATCH_H_ */
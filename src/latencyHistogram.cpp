@@ -0,0 +1,120 @@
+/*
+ * latencyHistogram.cpp
+ */
+
+#include "latencyHistogram.h"
+
+// Standard Includes
+#include <cmath>
+#include <algorithm>
+
+#define LATENCY_SUB_BUCKETS			(1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_LINEAR_BITS			7		// log2(LATENCY_LINEAR_BUCKETS)
+#define LATENCY_BUCKET_COUNT		(LATENCY_LINEAR_BUCKETS + (64 - LATENCY_LINEAR_BITS)*LATENCY_SUB_BUCKETS)
+
+
+/* Constructor */
+LatencyHistogram::LatencyHistogram(std::string name, std::string unit) {
+	this->name = name;
+	this->unit = unit;
+	buckets.resize(LATENCY_BUCKET_COUNT);
+	reset();
+}
+
+/* Functions */
+void LatencyHistogram::record(uint64_t value) {
+	// Count one value
+	buckets[bucketIndex(value)]++;
+	total++;
+	sum += value;
+	minValue = std::min(minValue, value);
+	maxValue = std::max(maxValue, value);
+}
+
+void LatencyHistogram::recordSeconds(double seconds) {
+	// Converts a time in seconds to the histogram unit, negative times (clock steps) count as zero
+	double scale = 1e6;
+	if(unit == "ns") {
+		scale = 1e9;
+	} else if(unit == "ms") {
+		scale = 1e3;
+	}
+	record((uint64_t)std::max(0.0, std::round(seconds*scale)));
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+	// Adds the counts of another histogram with the same unit
+	for(size_t i=0; i<buckets.size(); i++) {
+		buckets[i] += other.buckets[i];
+	}
+	total += other.total;
+	sum += other.sum;
+	minValue = std::min(minValue, other.minValue);
+	maxValue = std::max(maxValue, other.maxValue);
+}
+
+void LatencyHistogram::reset() {
+	std::fill(buckets.begin(), buckets.end(), 0);
+	total = 0;
+	sum = 0;
+	minValue = UINT64_MAX;
+	maxValue = 0;
+}
+
+uint64_t LatencyHistogram::count() const {
+	return total;
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const {
+	// Highest value equivalent to the bucket holding the requested percentile, 0 when empty
+	if(total == 0) {
+		return 0;
+	}
+	uint64_t target = (uint64_t)std::ceil(percent/100.0*total);
+	target = std::max<uint64_t>(target, 1);
+	uint64_t cumulative = 0;
+	for(size_t i=0; i<buckets.size(); i++) {
+		cumulative += buckets[i];
+		if(cumulative >= target) {
+			return std::min(bucketHighest(i), maxValue);
+		}
+	}
+	return maxValue;
+}
+
+double LatencyHistogram::mean() const {
+	return (total > 0) ? sum/total : 0;
+}
+
+void LatencyHistogram::writeJson(FILE* file) const {
+	// Writes the summary as one JSON object per line
+	fprintf(file,"{\"name\":\"%s\",\"unit\":\"%s\",\"count\":%llu,\"min\":%llu,\"mean\":%.1f,"
+			"\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"p99.9\":%llu,\"max\":%llu}\n",
+			name.c_str(), unit.c_str(), (unsigned long long)total,
+			(unsigned long long)(total > 0 ? minValue : 0), mean(),
+			(unsigned long long)percentile(50), (unsigned long long)percentile(90),
+			(unsigned long long)percentile(99), (unsigned long long)percentile(99.9),
+			(unsigned long long)maxValue);
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+	// Exact below the linear range, then 64 buckets between each power of two
+	if(value < LATENCY_LINEAR_BUCKETS) {
+		return value;
+	}
+	int msb = 63 - __builtin_clzll(value);
+	int shift = msb - LATENCY_SUB_BUCKET_BITS;
+	return LATENCY_LINEAR_BUCKETS + (msb - LATENCY_LINEAR_BITS)*LATENCY_SUB_BUCKETS + ((value >> shift) - LATENCY_SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::bucketHighest(size_t index) {
+	// Largest value that lands in a bucket
+	if(index < LATENCY_LINEAR_BUCKETS) {
+		return index;
+	}
+	size_t offset = index - LATENCY_LINEAR_BUCKETS;
+	int msb = LATENCY_LINEAR_BITS + offset/LATENCY_SUB_BUCKETS;
+	int shift = msb - LATENCY_SUB_BUCKET_BITS;
+	uint64_t lowest = (uint64_t)(LATENCY_SUB_BUCKETS + offset % LATENCY_SUB_BUCKETS) << shift;
+	return lowest + (((uint64_t)1 << shift) - 1);
+}
@@ -0,0 +1,56 @@
+/*
+ * latencyHistogram.h
+ */
+
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+// Standard Includes
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define LATENCY_LINEAR_BUCKETS		128		// Values below this are counted exactly
+#define LATENCY_SUB_BUCKET_BITS		6		// Sub buckets per power of two above that (2^6 = 64, < 1.6% error)
+
+
+/* Classes */
+// HDR style histogram of integer values (the unit is chosen by the caller, e.g. ns or us).
+// Buckets are exact up to 128 then 64 per power of two, so the relative error is bounded
+// at every scale and recording is a couple of shifts and an increment. Not thread safe,
+// each histogram should be written by one thread.
+class LatencyHistogram {
+public:
+	/* Data */
+	std::string		name;
+	std::string		unit;
+
+	/* Constructor */
+	LatencyHistogram(std::string name = "", std::string unit = "us");
+
+	/* Functions */
+	void record(uint64_t value);
+	void recordSeconds(double seconds);
+	void merge(const LatencyHistogram& other);
+	void reset();
+	uint64_t count() const;
+	uint64_t percentile(double percent) const;
+	double mean() const;
+	void writeJson(FILE* file) const;
+
+private:
+	/* Data */
+	std::vector<uint64_t>	buckets;
+	uint64_t				total;
+	uint64_t				minValue;
+	uint64_t				maxValue;
+	double					sum;
+
+	/* Functions */
+	static size_t bucketIndex(uint64_t value);
+	static uint64_t bucketHighest(size_t index);
+};
+
+
+#endif /* LATENCYHISTOGRAM_H_ */
@@ -0,0 +1,91 @@
+/*
+ * linkHealth.cpp
+ */
+
+#include "linkHealth.h"
+
+
+/* Constructor */
+LinkHealth::LinkHealth() : componentCount(0), lastKey(0), lastIndex(-1) {
+}
+
+/* Functions */
+void LinkHealth::countMessage(uint8_t sysid, uint8_t compid, uint8_t seq) {
+	// Counts a valid frame and any gap in its sender's sequence numbers. A frame from just behind the last
+	// (swapped or duplicated datagrams) wraps to a large gap, so it is counted as reordered and the
+	// sequence stays at the newest frame.
+	messages.add();
+	int index = findComponent(sysid, compid);
+	if(index < 0) {
+		return;
+	}
+	ComponentHealth& health = components[index];
+	health.received.add();
+	if(health.lastSeq >= 0) {
+		uint8_t gap = seq - (uint8_t)(health.lastSeq + 1);
+		if(gap > LINK_HEALTH_REORDER_GAP) {
+			health.reordered.add();
+			reordered.add();
+			return;
+		}
+		if(gap > 0) {
+			health.lost.add(gap);
+			lost.add(gap);
+		}
+	}
+	health.lastSeq = seq;
+}
+
+int LinkHealth::findComponent(uint8_t sysid, uint8_t compid) {
+	// Index of a component, adding it on first sight
+	uint16_t key = (sysid << 8) | compid;
+	if(key == lastKey && lastIndex >= 0) {
+		return lastIndex;
+	}
+	std::unordered_map<uint16_t, int>::iterator it = componentIndex.find(key);
+	int index = -1;
+	if(it != componentIndex.end()) {
+		index = it->second;
+	} else {
+		int count = componentCount.load(std::memory_order_relaxed);
+		if(count < LINK_HEALTH_MAX_COMPONENTS) {
+			components[count].sysid = sysid;
+			components[count].compid = compid;
+			index = count;
+			componentCount.store(count + 1, std::memory_order_release);
+		}
+		componentIndex[key] = index;
+	}
+	lastKey = key;
+	lastIndex = index;
+	return index;
+}
+
+int LinkHealth::numComponents() const {
+	return componentCount.load(std::memory_order_acquire);
+}
+
+const ComponentHealth& LinkHealth::component(int i) const {
+	return components[i];
+}
+
+double LinkHealth::lossPercent() const {
+	// Share of expected messages that never arrived
+	uint64_t numLost = lost.get();
+	uint64_t expected = messages.get() + numLost;
+	return (expected > 0) ? 100.0*numLost/expected : 0;
+}
+
+void LinkHealth::writeJson(FILE* file, const std::string& name, double time) const {
+	// One JSON object per line with cumulative counters, for monitoring to difference
+	fprintf(file,"{\"link\":\"%s\",\"time\":%.3f,\"messages\":%llu,\"lost\":%llu,\"reordered\":%llu,\"crc_errors\":%llu,\"parse_errors\":%llu,\"components\":[",
+			name.c_str(), time, (unsigned long long)messages.get(), (unsigned long long)lost.get(), (unsigned long long)reordered.get(),
+			(unsigned long long)crcErrors.get(), (unsigned long long)parseErrors.get());
+	int count = numComponents();
+	for(int i=0; i<count; i++) {
+		fprintf(file,"%s{\"sysid\":%u,\"compid\":%u,\"received\":%llu,\"lost\":%llu,\"reordered\":%llu}", i > 0 ? "," : "",
+				components[i].sysid, components[i].compid,
+				(unsigned long long)components[i].received.get(), (unsigned long long)components[i].lost.get(), (unsigned long long)components[i].reordered.get());
+	}
+	fprintf(file,"]}\n");
+}
@@ -0,0 +1,107 @@
+/*
+ * linkHealth.h
+ */
+
+#ifndef LINKHEALTH_H_
+#define LINKHEALTH_H_
+
+// Standard Includes
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+#define LINK_HEALTH_MAX_COMPONENTS	64		// Vehicles/components tracked per link, later ones only count towards the link totals
+#define LINK_HEALTH_REORDER_GAP		128		// Sequence gaps above this are a late or repeated frame, not loss
+
+
+/* Classes */
+// Counter written by one thread and read by any. The writer does a plain load and store rather than
+// an atomic add, so counting costs the same as a normal increment. Copyable so its owners stay movable.
+class RelaxedCounter {
+public:
+	/* Constructor */
+	RelaxedCounter() : value(0) {}
+	RelaxedCounter(const RelaxedCounter& other) : value(other.get()) {}
+
+	/* Functions */
+	void add(uint64_t n = 1) {
+		value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+	uint64_t get() const {
+		return value.load(std::memory_order_relaxed);
+	}
+
+private:
+	/* Data */
+	std::atomic<uint64_t> value;
+};
+
+// Single writer value of any lock free type (rates, last times), readable from other threads
+template <typename T>
+class RelaxedValue {
+public:
+	/* Constructor */
+	RelaxedValue() : value(T()) {}
+	RelaxedValue(const RelaxedValue& other) : value(other.get()) {}
+
+	/* Functions */
+	void set(T newValue) {
+		value.store(newValue, std::memory_order_relaxed);
+	}
+	T get() const {
+		return value.load(std::memory_order_relaxed);
+	}
+
+private:
+	/* Data */
+	std::atomic<T> value;
+};
+
+/* Structures */
+struct ComponentHealth {
+	uint8_t			sysid = 0;
+	uint8_t			compid = 0;
+	int				lastSeq = -1;				// Ingest thread only, -1 until the first message
+	RelaxedCounter	received;					// Messages received
+	RelaxedCounter	lost;						// Messages missing from the sequence numbers
+	RelaxedCounter	reordered;					// Frames arriving after a later one, or repeated
+};
+
+// Message level health of one link, written by the thread servicing the link. The render thread (or
+// anything else) reads it without locks: counters are relaxed atomics and components are published
+// by a release store of the component count after their ids are set.
+class LinkHealth {
+public:
+	/* Data */
+	RelaxedCounter	messages;					// Frames that passed the checksum
+	RelaxedCounter	crcErrors;					// Frames that failed the checksum
+	RelaxedCounter	parseErrors;				// Bad signatures and runs of bytes outside any frame
+	RelaxedCounter	lost;						// Sum of the per component sequence gaps
+	RelaxedCounter	reordered;					// Sum of the per component late or repeated frames
+
+	/* Constructor */
+	LinkHealth();
+
+	/* Functions */
+	void countMessage(uint8_t sysid, uint8_t compid, uint8_t seq);
+	int numComponents() const;
+	const ComponentHealth& component(int i) const;
+	double lossPercent() const;
+	void writeJson(FILE* file, const std::string& name, double time) const;
+
+private:
+	/* Data */
+	ComponentHealth							components[LINK_HEALTH_MAX_COMPONENTS];
+	std::atomic<int>						componentCount;
+	std::unordered_map<uint16_t, int>		componentIndex;		// Ingest thread only
+	uint16_t								lastKey;			// Most links carry one vehicle, skip the hash lookup
+	int										lastIndex;
+
+	/* Functions */
+	int findComponent(uint8_t sysid, uint8_t compid);
+};
+
+
+#endif /* LINKHEALTH_H_ */
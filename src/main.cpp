@@ -29,11 +29,18 @@
 #include "light.h"
 #include "imageTile.h"
 #include "mavlinkReceive.h"
+#include "mavReactor.h"
+#include "telemetryBus.h"
+#include "tlogReplay.h"
+#include "pcapReplay.h"
+#include "playbackClock.h"
 #include "mavAircraft.h"
 #include "skybox.h"
 #include "telemOverlay.h"
 #include "satTiles.h"
 #include "volumes.h"
+#include "trafficLayer.h"
+#include "statePublisher.h"
 
 // GLM Mathematics
 #include <glm/glm.hpp>
@@ -82,11 +89,25 @@ int main(int argc, char* argv[]) {
 	// Parse Command Line Arguments
 	bool wireFrameOn = false;
 	bool fpsOn = false;
+	bool recordOn = false;
+	string replayPath;
+	double replaySpeed = 1.0;
+	bool replayBySource = false;
+	string latencyPath;
+	string healthPath;
+	string busName;
 	int opt;
-	while((opt = getopt(argc, argv, "wf")) != -1) {
+	while((opt = getopt(argc, argv, "wfrp:s:ol:m:b:")) != -1) {
 		switch(opt) {
 		case 'w': wireFrameOn = true; break;
 		case 'f': fpsOn = true; break;
+		case 'r': recordOn = true; break;
+		case 'p': replayPath = optarg; break;
+		case 's': replaySpeed = atof(optarg); break;
+		case 'o': replayBySource = true; break;
+		case 'l': latencyPath = optarg; break;
+		case 'm': healthPath = optarg; break;
+		case 'b': busName = optarg; break;
 		}
 	}
 
@@ -116,6 +137,8 @@ int main(int argc, char* argv[]) {
 	Shader volumeShader("../Shaders/volume.vs","../Shaders/volume.frag");
 	loadingScreen.appendLoadingMessage("Loading lineShader.");
 	Shader lineShader("../Shaders/line.vs","../Shaders/line.frag");
+	loadingScreen.appendLoadingMessage("Loading trafficShader.");
+	Shader trafficShader("../Shaders/traffic.vs","../Shaders/traffic.frag");
 
 	/* Colours */
 	std::vector<glm::vec3> colorVec = {LC_BLUE, LC_RED, LC_GREEN, LC_YELLOW, LC_CYAN, LC_MAGENTA, LC_SILVER, LC_GRAY, LC_MAROON, LC_OLIVE, LC_DARKGREEN, LC_PURPLE, LC_TEAL, LC_NAVY};
@@ -148,28 +171,182 @@ int main(int argc, char* argv[]) {
 	   ====================================================== */
 	glm::vec3 worldOrigin = glm::vec3(settings.origin[0], settings.origin[1], settings.origin[2]/1000.0);
 	int num = settings.aircraftConList.size();
+	int numSlots = 0;
+	for(unsigned int i=0; i<settings.discoverList.size(); i++) {
+		numSlots += settings.discoverList[i].slots;
+	}
+	// Aircraft are referenced by pointer, so reserve room for every pool slot up front
 	std::vector<MavAircraft> mavAircraftList;
-	mavAircraftList.reserve(num);
+	mavAircraftList.reserve(num + numSlots);
 	std::vector<MavSocket> mavSocketList;
-	mavSocketList.reserve(num);
-	std::vector<std::thread*> threadList;
-	threadList.reserve(num);
-	std::thread* threadPt = NULL;
+	mavSocketList.reserve(num + settings.discoverList.size());
+	MavReactor mavReactor;
 	std::vector<TelemOverlay> telemOverlayList;
-	telemOverlayList.reserve(num);
+	telemOverlayList.reserve(num + numSlots);
+	// Each model file is loaded once and shared
+	std::map<std::string, std::shared_ptr<Model>> modelCache;
+	auto loadModel = [&modelCache](const std::string& path) -> std::shared_ptr<Model> {
+		std::shared_ptr<Model>& modelPt = modelCache[path];
+		if(!modelPt) {
+			modelPt.reset(new Model(path.c_str()));
+		}
+		return modelPt;
+	};
+	// Find or create the socket for an address and port
+	auto findSocket = [&mavSocketList, &loadingScreen](const std::string& ipString, const std::string& port) -> MavSocket* {
+		for(unsigned int j=0; j<mavSocketList.size(); j++) {
+			if(mavSocketList[j].host == ipString && mavSocketList[j].port == port) {
+				return &mavSocketList[j];
+			}
+		}
+		loadingScreen.appendLoadingMessage("Creating mavSocket: " + ipString + ":" + port);
+		mavSocketList.push_back(MavSocket(ipString, port));
+		return &mavSocketList.back();
+	};
 	// Load Mavlink Aircraft
 	for(unsigned int i=0; i<settings.aircraftConList.size(); i++) {
 		loadingScreen.appendLoadingMessage("Loading mavAircraft: " + settings.aircraftConList[i].name);
 		// Load Models
-		mavAircraftList.push_back(MavAircraft(settings.aircraftConList[i].filepath.c_str(),worldOrigin,settings.aircraftConList[i].name));
-		// Create thread to receive Mavlink messages
-		loadingScreen.appendLoadingMessage("Creating mavSocket: " + settings.aircraftConList[i].name);
-		mavSocketList.push_back(MavSocket(settings.aircraftConList[i].ipString, settings.aircraftConList[i].port, &mavAircraftList[i]));
-		threadPt = new std::thread(&MavSocket::startSocket,&mavSocketList[i]);
-		threadList.push_back(threadPt);
+		mavAircraftList.push_back(MavAircraft(loadModel(settings.aircraftConList[i].filepath),worldOrigin,settings.aircraftConList[i].name));
+		MavSocket* mavSocketPt = findSocket(settings.aircraftConList[i].ipString, settings.aircraftConList[i].port);
+		// Route messages to this aircraft by sysid, or take everything on the port
+		if(settings.aircraftConList[i].sysid > 0) {
+			mavSocketPt->addRoute(settings.aircraftConList[i].sysid, 0, mavAircraftList[i].telemetry.get());
+		} else {
+			if(mavSocketPt->defaultChannelPt != nullptr) {
+				printf("WARNING: %s shares port %s without a sysid, replacing the previous aircraft.\n",settings.aircraftConList[i].name.c_str(),mavSocketPt->port.c_str());
+			}
+			mavSocketPt->defaultChannelPt = mavAircraftList[i].telemetry.get();
+		}
 		// Create Telem Overlay
 		loadingScreen.appendLoadingMessage("Loading telemetry overlay: " + settings.aircraftConList[i].name);
-		telemOverlayList.push_back(TelemOverlay(&mavAircraftList[i],&textShader,&telemFont,colorVec[i],&settings));
+		telemOverlayList.push_back(TelemOverlay(&mavAircraftList[i],&textShader,&telemFont,colorVec[i % colorVec.size()],&settings));
+	}
+	// Pools of aircraft for vehicles discovered on a link
+	std::vector<std::unique_ptr<VehiclePool>> vehiclePools;
+	for(unsigned int i=0; i<settings.discoverList.size(); i++) {
+		const discoverDef& discover = settings.discoverList[i];
+		loadingScreen.appendLoadingMessage("Creating " + std::to_string(discover.slots) + " discovery slots on port " + discover.port);
+		vehiclePools.push_back(std::unique_ptr<VehiclePool>(new VehiclePool(discover.slots)));
+		VehiclePool* poolPt = vehiclePools.back().get();
+		std::shared_ptr<Model> modelPt = loadModel(discover.filepath);
+		for(int j=0; j<discover.slots; j++) {
+			unsigned int k = mavAircraftList.size();
+			mavAircraftList.push_back(MavAircraft(modelPt,worldOrigin,"port" + discover.port + "/slot" + std::to_string(j)));
+			mavAircraftList[k].attachSlot(poolPt, poolPt->slot(j));
+			telemOverlayList.push_back(TelemOverlay(&mavAircraftList[k],&textShader,&telemFont,colorVec[k % colorVec.size()],&settings));
+		}
+		findSocket(discover.ipString, discover.port)->setVehiclePool(poolPt);
+	}
+	// History retention, and where dropped samples go
+	if(!settings.historySpill.empty() && settings.positionHistory.length == 0 && settings.positionHistory.seconds == 0
+			&& settings.attitudeHistory.length == 0 && settings.attitudeHistory.seconds == 0) {
+		printf("WARNING: History spill without a history limit keeps every sample, the files in %s grow for the whole session.\n",settings.historySpill.c_str());
+	}
+	for(unsigned int i=0; i<mavAircraftList.size(); i++) {
+		mavAircraftList[i].setHistoryRetention(settings.positionHistory, settings.attitudeHistory);
+		if(!settings.historySpill.empty()) {
+			mavAircraftList[i].enableHistorySpill(settings.historySpill);
+		}
+	}
+	// Ingest policies apply to live links and replays alike
+	for(unsigned int i=0; i<mavSocketList.size(); i++) {
+		for(unsigned int j=0; j<settings.ingestList.size(); j++) {
+			if(settings.ingestList[j].linkPort == mavSocketList[i].port) {
+				mavSocketList[i].setIngestPolicy(settings.ingestList[j].message, settings.ingestList[j].policy);
+			}
+		}
+	}
+	std::unique_ptr<MavReplay> mavReplay;
+	TelemetryBus telemetryBus;
+	if(!busName.empty()) {
+		// Telemetry bus command line argument, view a running mavIngest instead of opening the links
+		loadingScreen.appendLoadingMessage("Attaching to telemetry bus: " + busName);
+		if(telemetryBus.attach(busName)) {
+			for(unsigned int i=0; i<mavAircraftList.size(); i++) {
+				BusAircraft* busAircraftPt = telemetryBus.findAircraft(mavAircraftList[i].name);
+				if(busAircraftPt != nullptr) {
+					mavAircraftList[i].attachBus(busAircraftPt, telemetryBus.clockOffset());
+				} else {
+					printf("WARNING: %s is not on telemetry bus %s.\n",mavAircraftList[i].name.c_str(),busName.c_str());
+				}
+			}
+		}
+	} else if(!replayPath.empty() && !mavSocketList.empty()) {
+		loadingScreen.appendLoadingMessage("Loading replay: " + replayPath);
+		if(PcapReplay::isCapture(replayPath)) {
+			// Packet capture, each UDP flow feeds the link with its port
+			std::vector<MavSocket*> replaySockets;
+			for(unsigned int i=0; i<mavSocketList.size(); i++) {
+				replaySockets.push_back(&mavSocketList[i]);
+			}
+			PcapReplay* pcapReplayPt = new PcapReplay(replayPath, replaySockets, &playbackClock);
+			pcapReplayPt->matchSourcePort = replayBySource;
+			mavReplay.reset(pcapReplayPt);
+		} else {
+			// Tlog, feed the link whose port is in the file name (portNNNN_...) or the first link
+			MavSocket* replaySocketPt = &mavSocketList[0];
+			for(unsigned int i=0; i<mavSocketList.size(); i++) {
+				if(replayPath.find("port" + mavSocketList[i].port + "_") != string::npos) {
+					replaySocketPt = &mavSocketList[i];
+				}
+			}
+			mavReplay.reset(new TlogReplay(replayPath, replaySocketPt, &playbackClock));
+		}
+		if(mavReplay->openFile()) {
+			playbackClock.startReplay(replaySpeed);
+			mavReplay->start();
+		}
+	} else {
+		for(unsigned int i=0; i<mavSocketList.size(); i++) {
+			// Record tlogs command line argument
+			if(recordOn) {
+				mavSocketList[i].enableRecording("../Logs");
+			}
+			// Forward raw datagrams to other tools
+			for(unsigned int j=0; j<settings.forwardList.size(); j++) {
+				if(settings.forwardList[j].linkPort == mavSocketList[i].port) {
+					mavSocketList[i].addForward(settings.forwardList[j].ipString, settings.forwardList[j].port);
+				}
+			}
+			mavReactor.addSocket(&mavSocketList[i]);
+		}
+		// Latency histogram command line argument (live links only)
+		if(!latencyPath.empty()) {
+			for(unsigned int i=0; i<mavAircraftList.size(); i++) {
+				mavAircraftList[i].recordLatency = true;
+			}
+		}
+	}
+	// Start receiving on all links
+	mavReactor.start();
+
+	// Publish the interpolated state to other tools
+	std::vector<std::unique_ptr<StatePublisher>> statePublishers;
+	for(unsigned int i=0; i<settings.publishList.size(); i++) {
+		std::unique_ptr<StatePublisher> publisher(new StatePublisher());
+		if(publisher->open(settings.publishList[i].type, settings.publishList[i].address, settings.publishList[i].rate, worldOrigin, mavAircraftList.size())) {
+			statePublishers.push_back(std::move(publisher));
+		}
+	}
+
+	// ADS-B traffic
+	std::unique_ptr<TrafficLayer> trafficLayer;
+	if(settings.trafficSet) {
+		loadingScreen.appendLoadingMessage("Loading traffic: " + settings.traffic.source);
+		trafficLayer.reset(new TrafficLayer(settings.traffic, worldOrigin, &playbackClock));
+		trafficLayer->source.start();
+	}
+
+	// Link health monitoring command line argument
+	FILE* healthFile = NULL;
+	double healthWriteLast = 0;
+	double rateUpdateLast = -MAV_RATE_UPDATE_PERIOD;
+	if(!healthPath.empty()) {
+		healthFile = fopen(healthPath.c_str(),"a");
+		if(healthFile == NULL) {
+			printf("WARNING: Could not open %s for link health.\n",healthPath.c_str());
+		}
 	}
 
 
@@ -269,7 +446,7 @@ int main(int argc, char* argv[]) {
 	std::vector<GLPL::Line2DVecGLMV3> mapList;
 	mapList.reserve(num);
 	for(unsigned int i=0; i<settings.aircraftConList.size(); i++) {
-		mapList.push_back(GLPL::Line2DVecGLMV3(&(mavAircraftList[i].positionHistory),1,0));
+		mapList.push_back(GLPL::Line2DVecGLMV3(&(mavAircraftList[i].trailHistory),1,0));
 		mapList[i].colour = colorVec[i];
 		myplot.axes.addLine(&mapList[i]);
 	}
@@ -298,6 +475,9 @@ int main(int argc, char* argv[]) {
 	/* ======================================================
 	 *                     Drawing Loop
 	   ====================================================== */
+	// One interpolation row per aircraft
+	InterpolationBatch interpolationBatch(mavAircraftList.size());
+
 	// Game Loop
 	while(!glfwWindowShouldClose(window)) {
 		// Set Frame Time
@@ -308,9 +488,26 @@ int main(int argc, char* argv[]) {
 		// Check Events
 		glfwPollEvents();
 
-		// Update Aircraft Position
+		// Replay seek, start the aircraft again from the new position
+		if(mavReplay && mavReplay->resetPending()) {
+			for(unsigned int i=0; i<mavAircraftList.size(); i++) {
+				mavAircraftList[i].restartReplay();
+			}
+			mavReplay->acknowledgeReset();
+		}
+
+		// Update Aircraft Position, interpolating every aircraft in one pass
+		for(unsigned int i=0; i<mavAircraftList.size(); i++) {
+			mavAircraftList[i].updatePositionAttitude(interpolationBatch, i);
+		}
+		interpolationBatch.interpolate();
 		for(unsigned int i=0; i<mavAircraftList.size(); i++) {
-			mavAircraftList[i].updatePositionAttitude();
+			mavAircraftList[i].applyInterpolation(interpolationBatch, i);
+		}
+
+		// Publish the state just interpolated
+		for(unsigned int i=0; i<statePublishers.size(); i++) {
+			statePublishers[i]->update(currentFrame, playbackClock.now(), mavAircraftList);
 		}
 
 		// Do keyboard movement
@@ -343,13 +540,27 @@ int main(int argc, char* argv[]) {
 			mavAircraftList[i].Draw(lightingShader);
 		}
 
+		// Draw Traffic
+		if(trafficLayer) {
+			trafficLayer->update(playbackClock.now());
+			trafficShader.Use();
+			glUniformMatrix4fv(glGetUniformLocation(trafficShader.Program,"projection"),1,GL_FALSE,glm::value_ptr(projection));
+			glUniformMatrix4fv(glGetUniformLocation(trafficShader.Program,"view"),1,GL_FALSE,glm::value_ptr(view));
+			glUniform1f(glGetUniformLocation(trafficShader.Program,"scale"),1.0f);
+			glUniform3f(glGetUniformLocation(trafficShader.Program,"lightDirection"),-0.2f,-1.0f,-0.3f);
+			glUniform3f(glGetUniformLocation(trafficShader.Program,"trafficColour"),1.0f,0.6f,0.0f);
+			trafficLayer->Draw(trafficShader);
+		}
+
 
 		// Draw telem overlay
 		simpleShader.Use();
 		glUniformMatrix4fv(glGetUniformLocation(simpleShader.Program,"projection"),1,GL_FALSE,glm::value_ptr(projection));
 		glUniformMatrix4fv(glGetUniformLocation(simpleShader.Program,"view"),1,GL_FALSE,glm::value_ptr(view));
 		for(unsigned int i=0; i<telemOverlayList.size(); i++) {
-			telemOverlayList[i].Draw(simpleShader, projection, view, &camera);
+			if(mavAircraftList[i].active) {
+				telemOverlayList[i].Draw(simpleShader, projection, view, &camera);
+			}
 		}
 
 		// Draw tile(s)
@@ -443,22 +654,94 @@ int main(int argc, char* argv[]) {
 			sh << "Increment aircraft:       z-x\n";
 			sh << "Increment track view:     n\n";
 			sh << "Toggle Mouse Movement:  p\n";
+			if(!playbackClock.isLive()) {
+				sh << "Pause Replay:             space\n";
+				sh << "Seek Replay -10s/+10s:    left-right\n";
+				sh << "Replay Speed x0.5/x2:     down-up\n";
+			}
+			// Link health, read lock free from the ingest counters
+			for(unsigned int i=0; i<mavSocketList.size(); i++) {
+				const IngestStats& stats = mavSocketList[i].stats;
+				const LinkHealth* health = mavSocketList[i].health.get();
+				sh << "Link " << mavSocketList[i].port << ": " << int(stats.datagramRate.get()) << " pkt/s, "
+				   << int(stats.byteRate.get()/1000) << " kB/s, " << health->lossPercent() << "% lost, "
+				   << health->reordered.get() << " reordered, " << health->crcErrors.get() << " crc, " << health->parseErrors.get() << " parse errors\n";
+			}
+			for(unsigned int i=0; i<mavAircraftList.size(); i++) {
+				if(mavAircraftList[i].latestOverwritten > 0) {
+					sh << mavAircraftList[i].name << ": " << mavAircraftList[i].latestOverwritten << " latest only samples replaced before drawn\n";
+				}
+			}
+			if(trafficLayer) {
+				sh << "Traffic " << trafficLayer->source.source << ": " << trafficLayer->table.count << " targets, "
+				   << trafficLayer->numDrawn << " drawn, " << trafficLayer->source.parseErrors.get() << " parse errors\n";
+			}
 			(&helpFont)->RenderText(textShaderPt,sh.str(),0.0f,0.05f,1.0f,glm::vec3(1.0f, 1.0f, 0.0f),1);
 		}
 
 		// Swap buffers
 		glfwSwapBuffers(window);
 
+		// Arrival to drawn latency
+		if(!latencyPath.empty() && playbackClock.isLive()) {
+			double timeDrawn = playbackClock.now();
+			for(unsigned int i=0; i<mavAircraftList.size(); i++) {
+				mavAircraftList[i].recordFrameDrawn(timeDrawn);
+			}
+		}
+
+		// Link rates, taken here so a stalled link shows 0
+		if((currentFrame - rateUpdateLast) >= MAV_RATE_UPDATE_PERIOD) {
+			for(unsigned int i=0; i<mavSocketList.size(); i++) {
+				mavSocketList[i].updateRates(currentFrame);
+			}
+			rateUpdateLast = currentFrame;
+		}
+
+		// Export link health
+		if(healthFile != NULL && (currentFrame - healthWriteLast) > MAV_STATS_REPORT_PERIOD) {
+			for(unsigned int i=0; i<mavSocketList.size(); i++) {
+				mavSocketList[i].writeHealthJson(healthFile, playbackClock.now());
+			}
+			fflush(healthFile);
+			healthWriteLast = currentFrame;
+		}
+
 		// Sleep to lower framerate
 		//std::this_thread::sleep_for(std::chrono::milliseconds(int(1000.0/5.0)));
 
 	}
 
 	glfwTerminate();
-	// Close mavlink socket
-	for(unsigned int i=0; i<mavSocketList.size(); i++) {
-		mavSocketList[i].closeSocket();
-		threadList[i]->join();
+	// Close mavlink sockets
+	if(mavReplay) {
+		mavReplay->stop();
+	}
+	mavReactor.stop();
+	if(trafficLayer) {
+		trafficLayer->source.stop();
+	}
+	for(unsigned int i=0; i<statePublishers.size(); i++) {
+		statePublishers[i]->report();
+	}
+
+	// Close link health export
+	if(healthFile != NULL) {
+		fclose(healthFile);
+	}
+
+	// Write latency histograms
+	if(!latencyPath.empty() && playbackClock.isLive()) {
+		FILE* latencyFile = fopen(latencyPath.c_str(),"w");
+		if(latencyFile != NULL) {
+			for(unsigned int i=0; i<mavAircraftList.size(); i++) {
+				mavAircraftList[i].visibleLatency.writeJson(latencyFile);
+				mavAircraftList[i].drawnLatency.writeJson(latencyFile);
+			}
+			fclose(latencyFile);
+		} else {
+			printf("WARNING: Could not write latencies to %s.\n",latencyPath.c_str());
+		}
 	}
 
 	// Stop Satellite Tile Threads
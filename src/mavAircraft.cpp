@@ -7,13 +7,19 @@
 
 #include "mavAircraft.h"
 
+// Standard Includes
+#include <algorithm>
+
 
 /* Constructor */
-MavAircraft::MavAircraft(const GLchar* path, glm::dvec3 origin, string name) : Model(path) {
+MavAircraft::MavAircraft(std::shared_ptr<Model> modelPt, glm::dvec3 origin, string name) : modelPt(modelPt), positionHistory(2), attitudeHistory(2),
+		telemetry(new TelemetryChannel()), visibleLatency(name + "/arrival_to_visible"), drawnLatency(name + "/arrival_to_drawn") {
 
 	// Set Geoposition (temporary)
 	this->geoPosition = glm::dvec3(-37.958926f, 145.238343f, 0.0f);
-	this->geoPositionHistory.push_back(this->geoPosition);
+
+	// Path plot
+	trailHistory.reserve(MAV_TRAIL_LENGTH);
 
 	// Set Origin
 	this->origin = origin;
@@ -24,174 +30,439 @@ MavAircraft::MavAircraft(const GLchar* path, glm::dvec3 origin, string name) : M
 	// Set Airspeed
 	airspeed = 0;
 	heading = 0;
+	telemetry->state.read(state);
+
+	// Arrival times waiting for a frame to be drawn
+	pendingDrawArrivals.reserve(TELEMETRY_QUEUE_LENGTH);
 }
 
 /* Functions */
-void MavAircraft::updatePositionAttitude() {
-	// Set new time
-	currTime = glfwGetTime() - timeStart;
-	if (timePositionHistory.size()>0) {
-		minDiff = std::min(minDiff,timePositionHistory.back() - (currTime+timeStartMavlink-timeDelay));
+void MavAircraft::attachSlot(VehiclePool* poolPt, VehicleSlot* slotPt) {
+	// Follows a pool slot, inactive until a vehicle is discovered in it
+	this->poolPt = poolPt;
+	this->slotPt = slotPt;
+	poolPt->setChannel(slotPt - poolPt->slot(0), telemetry.get());
+	active = false;
+}
 
-		// Adjust delay if catching up to real messages
-		if (minDiff < 0) {
-			timeDelay += timeDelay;
-			printf("Incremented time delay. Current Delay: %f\n",timeDelay);
-			minDiff = timePositionHistory.back() - (currTime+timeStartMavlink-timeDelay);
+void MavAircraft::followSlot() {
+	// Picks up a newly discovered vehicle, retires a silent one and clears the slot once the ingest lets go
+	int status = slotPt->status.load(std::memory_order_acquire);
+	if(status == VEHICLE_SLOT_ACTIVE && !active) {
+		name = "sysid " + std::to_string(slotPt->sysid);
+		active = true;
+	} else if(status == VEHICLE_SLOT_ACTIVE && !playbackClock.catchingUp && silentTime() > VEHICLE_SILENT_TIMEOUT) {
+		if(poolPt->retire(slotPt)) {
+			printf("%s: silent for %.0f s, retiring\n",name.c_str(),VEHICLE_SILENT_TIMEOUT);
+			active = false;
 		}
+	} else if(status == VEHICLE_SLOT_RETIRED) {
+		// No more writes, so this thread can empty and clear the channel
+		TelemetrySample sample;
+		while(telemetry->queue.pop(sample)) {}
+		telemetry->state.write([](TelemetryState& state) {
+			memset((void*)&state, 0, sizeof(state));
+		});
+		resetHistory();
+		poolPt->release(slotPt);
+	}
+}
 
-		// Check to move to next pair of position messages
-		std::vector<float>::iterator lowpos = std::lower_bound(timePositionHistory.begin(),timePositionHistory.end(),currTime+timeStartMavlink-timeDelay);
-		currentPosMsgIndex = lowpos - timePositionHistory.begin();
+double MavAircraft::silentTime() {
+	// Time since the slot's vehicle was last heard. Replays measure it against the newest message replayed,
+	// so seeking or pausing doesn't make vehicles look silent.
+	double reference = playbackClock.isLive() ? playbackClock.now() : poolPt->lastIngest.get();
+	return reference - slotPt->lastSeen.get();
+}
 
+void MavAircraft::resetHistory() {
+	// Back to the state of a new aircraft, keeping the allocations for the next vehicle
+	geoPosition = glm::dvec3(-37.958926f, 145.238343f, 0.0f);
+	position = glm::dvec3(0);
+	velocity = glm::dvec3(0);
+	positionHistory.clear();
+	trailHistory.clear();
+	trailStride = 1;
+	trailSkipped = 0;
+	firstPositionMessage = true;
+	currentPosMsgIndex = 0;
+	posSegmentValid = false;
+	attitude = glm::dvec3(0);
+	attitudeHistory.clear();
+	firstAttitudeMessage = true;
+	currentAttMsgIndex = 0;
+	attSegmentValid = false;
+	timeStart = 0;
+	timeStartMavlink = 0;
+	timeStartAtt = 0;
+	timeStartMavlinkAtt = 0;
+	timeDelay = 0.1;
+	currTime = 0;
+	dtPos = 0;
+	dtAtt = 0;
+	minDiff = 10;
+	displayTime = 0;
+	clockEstimator.reset();
+	airspeed = 0;
+	heading = 0;
 
-		// Check to move to the next pair of attitude messages
-		std::vector<float>::iterator lowatt = std::lower_bound(timeAttitudeHistory.begin(),timeAttitudeHistory.end(),currTime+timeStartMavlinkAtt-timeDelay);
-		currentAttMsgIndex = lowatt - timeAttitudeHistory.begin();
+	// Treat whatever is in the channel now as already seen
+	stateVersion = telemetry->state.read(state);
+	for(int type=0; type < TELEM_TYPE_COUNT; type++) {
+		latestVersion[type] = telemetry->latest[type].version();
+	}
+	pendingDrawArrivals.clear();
+	tempTime.clear();
+	tempTime2.clear();
+	tempPos.clear();
+	tempAtt.clear();
+	tempVel.clear();
+}
 
-		// Calculate position offset
-		if(!firstPositionMessage) {
-			dtPos = currTime - (timePositionHistory[currentPosMsgIndex]-timeStartMavlink) - timeDelay;
-			interpolatePosition();
-		}
+void MavAircraft::restartReplay() {
+	// After a replay seek, drops the samples queued from before it and starts again as a new aircraft.
+	// The replay waits for this, so nothing is being queued meanwhile.
+	TelemetrySample sample;
+	while(telemetry->queue.pop(sample)) {}
+	resetHistory();
+}
 
-		// Calculate attitude offset
-		if(!firstAttitudeMessage) {
-			dtAtt = currTime - (timeAttitudeHistory[currentAttMsgIndex]-timeStartMavlinkAtt) - timeDelay;
-			interpolateAttitude();
-		}
-	}
+void MavAircraft::setHistoryRetention(historyDef position, historyDef attitude) {
+	// Limits the history kept, 0 length and seconds keep the whole flight
+	positionHistory.setRetention(position);
+	attitudeHistory.setRetention(attitude);
 }
 
-void MavAircraft::Draw(Shader shader) {
-	if(currentPosMsgIndex>1) {
-		// Do Translation and Rotation
-		glm::mat4 model;
-		model = glm::translate(model,glm::vec3(position[0],position[2],position[1]));// Translate first due to GLM ordering, rotations opposite order
-		model = glm::rotate(model,(float)attitude[2],glm::vec3(0.0f,1.0f,0.0f)); // Rotate about y, yaw
-		model = glm::rotate(model,(float)attitude[1],glm::vec3(0.0f,0.0f,1.0f)); // Rotate about z, pitch
-		model = glm::rotate(model,(float)attitude[0],glm::vec3(1.0f,0.0f,0.0f)); // Rotate about x, roll
+void MavAircraft::enableHistorySpill(std::string directory) {
+	// Keeps the history files as <directory>/<name>_position.hist and _attitude.hist, rather than temporary files
+	std::string fileName = name;
+	std::replace(fileName.begin(), fileName.end(), '/', '_');
+	std::replace(fileName.begin(), fileName.end(), ' ', '_');
+	positionHistory.setFile(directory + "/" + fileName + "_position.hist");
+	attitudeHistory.setFile(directory + "/" + fileName + "_attitude.hist");
+}
 
-		// Update Uniforms
-		glUniformMatrix4fv(glGetUniformLocation(shader.Program,"model"),1,GL_FALSE,glm::value_ptr(model));
+void MavAircraft::addTrailPoint(glm::dvec3 point) {
+	// Keeps every trailStride'th position for the path plot. When full, every other point is dropped
+	// and the stride doubles, so the whole flight stays in a fixed size buffer.
+	if(++trailSkipped < trailStride) {
+		return;
+	}
+	trailSkipped = 0;
+	if(trailHistory.size() >= MAV_TRAIL_LENGTH) {
+		for(size_t i=0; i < trailHistory.size()/2; i++) {
+			trailHistory[i] = trailHistory[2*i + 1];
+		}
+		trailHistory.resize(trailHistory.size()/2);
+		trailStride *= 2;
+	}
+	trailHistory.push_back(point);
+}
 
-		// Draw Model
-		Model::Draw(shader);
+void MavAircraft::attachBus(BusAircraft* busPt, double clockOffset) {
+	// Reads samples and state from a shared memory bus slot instead of the local queue
+	this->busPt = busPt;
+	busClockOffset = clockOffset;
+	busCursor = busPt->samples.oldest();
+	busLost = 0;
+	stateVersion = busPt->state.read(state);
+	for(int type=0; type < TELEM_TYPE_COUNT; type++) {
+		latestVersion[type] = 0;
+	}
+}
 
+bool MavAircraft::nextSample(TelemetrySample& sample) {
+	// Next sample from the bus or the local queue, false once drained
+	if(busPt == nullptr) {
+		return telemetry->queue.pop(sample);
+	}
+	if(!busPt->samples.read(busCursor, sample, busLost)) {
+		return false;
 	}
+	sample.timeReceived += busClockOffset;
+	return true;
 }
 
-// Calculate position at next frame
-void MavAircraft::interpolatePosition() {
-	if(currentPosMsgIndex>1) {
-		// Recalculate Interpolation Constants
-		calculatePositionInterpolationConstants();
+void MavAircraft::processTelemetry() {
+	// Drains the samples received by the socket thread since the last frame
+	TelemetrySample sample;
+	double timeDrained = playbackClock.now();
+	while(nextSample(sample)) {
+		applySample(sample);
+
+		// Latency measurement
+		if(recordLatency) {
+			visibleLatency.recordSeconds(timeDrained - sample.timeReceived);
+			pendingDrawArrivals.push_back(sample.timeReceived);
+		}
+	}
 
-		// Store Past Position
-		glm::dvec3 oldPosition = position;
+	// Take the newest sample of each latest only message type, if it changed since the last frame
+	const LatestSample* latestPt = (busPt != nullptr) ? busPt->latest : telemetry->latest;
+	for(int type=0; type < TELEM_TYPE_COUNT; type++) {
+		uint32_t version = latestPt[type].version();
+		if(version == latestVersion[type]) {
+			continue;
+		}
+		if(latestVersion[type] != 0) {
+			latestOverwritten += (version - latestVersion[type])/2 - 1;
+		}
+		latestVersion[type] = latestPt[type].read(sample);
+		if(busPt != nullptr) {
+			sample.timeReceived += busClockOffset;
+		}
+		if(!isNewerSample(sample)) {
+			continue;
+		}
+		applySample(sample);
+		if(recordLatency) {
+			visibleLatency.recordSeconds(timeDrained - sample.timeReceived);
+			pendingDrawArrivals.push_back(sample.timeReceived);
+		}
+	}
 
-		// Calculate Positions
-		this->position[0] = (0.5*xPosConst[0]*dtPos*dtPos) + (xPosConst[1]*dtPos) + xPosConst[2];
-		this->position[1] = (0.5*yPosConst[0]*dtPos*dtPos) + (yPosConst[1]*dtPos) + yPosConst[2];
-		this->position[2] = (0.5*zPosConst[0]*dtPos*dtPos) + (zPosConst[1]*dtPos) + zPosConst[2];
+	// Copy the vehicle state only when it has changed
+	const TelemetryBlock& block = (busPt != nullptr) ? busPt->state : telemetry->state;
+	if(block.version() != stateVersion) {
+		stateVersion = block.read(state);
+		if(busPt != nullptr && (state.fieldsValid & TELEM_STATE_HEARTBEAT)) {
+			// Times in the state are on the ingest process's clock, like the sample times
+			state.timeHeartbeat += busClockOffset;
+		}
+		airspeed = state.airspeed;
+		heading = state.heading;
+	}
+}
 
-		// Calculate Velocity
-		this->velocity[0] = (position[0] - oldPosition[0])/(-dtPos);
-		this->velocity[1] = (position[1] - oldPosition[1])/(-dtPos);
-		this->velocity[2] = (position[2] - oldPosition[2])/(-dtPos);
+bool MavAircraft::isNewerSample(const TelemetrySample& sample) {
+	// Latest only samples bypass the queue, so keep the histories in time order if both feed one type
+	if(sample.type == TELEM_POSITION && !positionHistory.empty()) {
+		return sample.timeBoot > positionHistory.lastTime();
+	}
+	if(sample.type == TELEM_ATTITUDE && !attitudeHistory.empty()) {
+		return sample.timeBoot > attitudeHistory.lastTime();
+	}
+	return true;
+}
 
-		tempTime.push_back(currTime+timeStartMavlink-timeDelay);
-		tempPos.push_back(position);
-		tempVel.push_back(velocity);
+void MavAircraft::recordFrameDrawn(double timeDrawn) {
+	// Called once the frame using the samples drained this frame has been swapped
+	for(size_t i=0; i < pendingDrawArrivals.size(); i++) {
+		drawnLatency.recordSeconds(timeDrawn - pendingDrawArrivals[i]);
+	}
+	pendingDrawArrivals.clear();
+}
 
+void MavAircraft::applySample(const TelemetrySample& sample) {
+	// Stores a decoded sample in the history used for interpolation
+	switch(sample.type) {
+		case TELEM_POSITION: {
+			// First Message
+			if(firstPositionMessage) {
+				timeStart = sample.timeReceived;
+				timeStartMavlink = sample.timeBoot;
+				printf("%s: Our Position Start Time: %f, Mavlink Start Time: %f\n",name.c_str(),timeStart,timeStartMavlink);
+			}
+
+			// Store GeoPosition
+			geoPosition = sample.value;
+
+			/* Convert Geodetic to ECEF */
+			glm::dvec3 ecefPosition = geo2ECEF(geoPosition);
+			glm::dvec3 ecefOrigin = geo2ECEF(origin);
+
+			/* Convert from ECEF to NEU */
+			glm::dvec3 pos = ecef2NEU(ecefPosition, ecefOrigin, origin);
+			addTrailPoint(pos);
+
+			// Store position, velocity (to enforce end position) and time
+			glm::dvec3 columns[2] = {pos, sample.rate};
+			positionHistory.push(sample.timeBoot, columns);
+			if(!firstPositionMessage) {
+				velocity = glm::dvec3(sample.rate[0], sample.rate[1], -sample.rate[2]);		// Down to up
+			} else {
+				// Store first position and time
+				position = pos;
+				currTime = playbackClock.now() - timeStart;
+			}
+
+			// Clock estimate
+			clockEstimator.observe(sample.timeBoot, sample.timeReceived);
+
+			// Toggle after recieving first message
+			firstPositionMessage = false;
+			break;
+		}
+		case TELEM_ATTITUDE: {
+			// First Message
+			if(firstAttitudeMessage) {
+				timeStartAtt = sample.timeReceived;
+				timeStartMavlinkAtt = sample.timeBoot;
+				printf("%s: Our Attitude Start Time: %f, Mavlink Start Time: %f\n",name.c_str(),timeStartAtt,timeStartMavlinkAtt);
+			}
+
+			// Store Rotations, Rotation Rates and Time
+			attitude = sample.value;
+			glm::dvec3 columns[2] = {sample.value, sample.rate};
+			attitudeHistory.push(sample.timeBoot, columns);
+
+			// Clock estimate
+			clockEstimator.observe(sample.timeBoot, sample.timeReceived);
+
+			// Reset First Message Switch
+			firstAttitudeMessage = false;
+			break;
+		}
+		case TELEM_CLOCK: {
+			// Time only observation
+			clockEstimator.observe(sample.timeBoot, sample.timeReceived);
+			break;
+		}
+		default: {
+			break;
+		}
 	}
 }
 
-void MavAircraft::interpolateAttitude() {
-	if(currentAttMsgIndex>1) {
-		// Recalculate Interpolation Constants
-		calculateAttitudeInterpolationConstants();
+void MavAircraft::updatePositionAttitude(InterpolationBatch& batch, size_t row) {
+	// Takes in new samples and loads this aircraft's row of the frame's interpolation
+	// Discovered vehicles come and go
+	if(slotPt != nullptr) {
+		followSlot();
+		if(!active) {
+			loadPositionSegment(batch, row);
+			loadAttitudeSegment(batch, row);
+			return;
+		}
+	}
+
+	// Drain new samples
+	processTelemetry();
+
+	// Set new time
+	double timeNow = playbackClock.now();
+	currTime = timeNow - timeStart;
+	if (!positionHistory.empty()) {
+		// Autopilot time to display, from the shared clock estimate
+		displayTime = clockEstimator.bootTime(timeNow) - timeDelay;
+		minDiff = std::min(minDiff,(float)(positionHistory.lastTime() - displayTime));
+
+		// Adjust delay if catching up to real messages (a replay filling in after a seek is expected to lag)
+		if (playbackClock.catchingUp) {
+			minDiff = 10;
+		} else if (minDiff < 0) {
+			timeDelay += timeDelay;
+			printf("Incremented time delay. Current Delay: %f\n",timeDelay);
+			displayTime = clockEstimator.bootTime(timeNow) - timeDelay;
+			minDiff = positionHistory.lastTime() - displayTime;
+		}
+
+		// Check to move to next pair of position messages. Seeking back past the retained history holds the oldest.
+		currentPosMsgIndex = positionHistory.advance(currentPosMsgIndex, displayTime);
+		if(currentPosMsgIndex >= positionHistory.end()) {
+			// Clock is ahead of the data (replay seeking forward), hold the latest message
+			currentPosMsgIndex = positionHistory.end() - 1;
+		}
+
 
-		// Calculate Attitude
-		this->attitude[0] = (xAttConst[0]*dtAtt) + xAttConst[1];
-		this->attitude[1] = (yAttConst[0]*dtAtt) + yAttConst[1];
-		this->attitude[2] = (zAttConst[0]*dtAtt) + zAttConst[1];
+		// Check to move to the next pair of attitude messages
+		currentAttMsgIndex = attitudeHistory.advance(currentAttMsgIndex, displayTime);
+		if(currentAttMsgIndex >= attitudeHistory.end() && !attitudeHistory.empty()) {
+			currentAttMsgIndex = attitudeHistory.end() - 1;
+		}
+
+		// Calculate position offset
+		if(!firstPositionMessage) {
+			dtPos = displayTime - positionHistory.time(currentPosMsgIndex);
+		}
 
-		tempTime2.push_back(currTime+timeStartMavlinkAtt-timeDelay);
-		tempAtt.push_back(attitude);
+		// Calculate attitude offset
+		if(!firstAttitudeMessage) {
+			dtAtt = displayTime - attitudeHistory.time(currentAttMsgIndex);
+		}
 	}
+	loadPositionSegment(batch, row);
+	loadAttitudeSegment(batch, row);
 }
 
-void MavAircraft::calculatePositionInterpolationConstants() {
-	// Get Index
-	int pos = currentPosMsgIndex;
-
-	// x(t) = 0.5*a*t^2+b*t+c
-	// (t1,x1), (t2,x2), (t3,x3), t2 is current
-	float t1 = timePositionHistory[pos-2]-timePositionHistory[pos];
-	float t2 = timePositionHistory[pos-1]-timePositionHistory[pos];
-	float t3 = 0;
+void MavAircraft::loadPositionSegment(InterpolationBatch& batch, size_t row) {
+	// Position segment from the sample before the display time to the one after, or holding still
+	size_t index = currentPosMsgIndex;
+	if(!active || firstPositionMessage || index <= positionHistory.begin() || index >= positionHistory.end() ||
+			!positionHistory.available(index - 1) || !positionHistory.available(index)) {
+		batch.setPositionSegment(row, 0, 1, position, glm::dvec3(0), position, glm::dvec3(0));
+		return;
+	}
+	if(!posSegmentValid || posSegmentIndex != index) {
+		for(int i=0; i<2; i++) {
+			posSegmentTime[i] = positionHistory.time(index - 1 + i);
+			posSegment[i] = positionHistory.value(HISTORY_POSITION, index - 1 + i);
+			glm::dvec3 rate = positionHistory.value(HISTORY_VELOCITY, index - 1 + i);
+			velSegment[i] = glm::dvec3(rate[0], rate[1], -rate[2]);		// Down to up
+		}
+		posSegmentIndex = index;
+		posSegmentValid = true;
+	}
+	double h = posSegmentTime[1] - posSegmentTime[0];
+	double s = (displayTime - posSegmentTime[0])/std::max(h, INTERPOLATION_MIN_SEGMENT);
+	batch.setPositionSegment(row, s, h, posSegment[0], velSegment[0], posSegment[1], velSegment[1]);
+}
 
-	// Find inverse matrix of [x1,x2,v2]=[BLAH][a,b,c]
-	glm::mat3x3 A = glm::mat3x3(0.5*t1*t1, t1, 1,0.5*t2*t2,t2,1,0.5*t3*t3, t3, 1);
-	glm::mat3x3 inv = glm::inverse(A);
+void MavAircraft::loadAttitudeSegment(InterpolationBatch& batch, size_t row) {
+	// Attitude segment either side of the display time, or holding still
+	size_t index = currentAttMsgIndex;
+	if(!active || firstAttitudeMessage || index <= attitudeHistory.begin() || index >= attitudeHistory.end() ||
+			!attitudeHistory.available(index - 1) || !attitudeHistory.available(index)) {
+		glm::dvec4 q = eulerToQuaternion(attitude);
+		batch.setAttitudeSegment(row, 0, q, q);
+		return;
+	}
+	if(!attSegmentValid || attSegmentIndex != index) {
+		for(int i=0; i<2; i++) {
+			attSegmentTime[i] = attitudeHistory.time(index - 1 + i);
+			attSegment[i] = eulerToQuaternion(attitudeHistory.value(HISTORY_ATTITUDE, index - 1 + i));
+		}
+		attSegmentIndex = index;
+		attSegmentValid = true;
+	}
+	double h = attSegmentTime[1] - attSegmentTime[0];
+	double s = (displayTime - attSegmentTime[0])/std::max(h, INTERPOLATION_MIN_SEGMENT);
+	batch.setAttitudeSegment(row, s, attSegment[0], attSegment[1]);
+}
 
-	// Constants
-	glm::dvec3 xvec = glm::dvec3(positionHistory[pos-2][0],positionHistory[pos-1][0],positionHistory[pos][0]);
-	glm::dvec3 yvec = glm::dvec3(positionHistory[pos-2][1],positionHistory[pos-1][1],positionHistory[pos][1]);
-	glm::dvec3 zvec = glm::dvec3(positionHistory[pos-2][2],positionHistory[pos-1][2],positionHistory[pos][2]);
+void MavAircraft::applyInterpolation(const InterpolationBatch& batch, size_t row) {
+	// Takes this aircraft's results from the frame's interpolation
+	for(int a=0; a<3; a++) {
+		position[a] = batch.position[a][row];
+		velocity[a] = batch.velocity[a][row];
+		attitude[a] = batch.attitude[a][row];
+	}
 
-	xPosConst = xvec*inv;		// Flipped due to GLM ordering
-	yPosConst = yvec*inv;		// Flipped due to GLM ordering
-	zPosConst = zvec*inv;		// Flipped due to GLM ordering
+#if MAV_DEBUG_INTERPOLATION
+	tempTime.push_back(displayTime);
+	tempPos.push_back(position);
+	tempVel.push_back(velocity);
+	tempTime2.push_back(displayTime);
+	tempAtt.push_back(attitude);
+#endif
 }
 
-void MavAircraft::calculateAttitudeInterpolationConstants() {
-	// Get Index
-	int pos = currentAttMsgIndex;
+void MavAircraft::Draw(Shader shader) {
+	if(active && currentPosMsgIndex>1) {
+		// Do Translation and Rotation
+		glm::mat4 model;
+		model = glm::translate(model,glm::vec3(position[0],position[2],position[1]));// Translate first due to GLM ordering, rotations opposite order
+		model = glm::rotate(model,(float)attitude[2],glm::vec3(0.0f,1.0f,0.0f)); // Rotate about y, yaw
+		model = glm::rotate(model,(float)attitude[1],glm::vec3(0.0f,0.0f,1.0f)); // Rotate about z, pitch
+		model = glm::rotate(model,(float)attitude[0],glm::vec3(1.0f,0.0f,0.0f)); // Rotate about x, roll
 
-	// x(t) = at+b
-	// v(t) = a
-	// (t1,x1), (t2,x2), t2 is current
-	float t1 = timeAttitudeHistory[pos-1]-timeAttitudeHistory[pos];
-	float t2 = 0;
+		// Update Uniforms
+		glUniformMatrix4fv(glGetUniformLocation(shader.Program,"model"),1,GL_FALSE,glm::value_ptr(model));
 
-	// Find inverse matrix of [x1,x2]=[BLAH][a,b]
-	glm::mat2x2 A = glm::mat2x2(t1,1, t2,1);
-	glm::mat2x2 inv = glm::inverse(A);
+		// Draw Model
+		modelPt->Draw(shader);
 
-	// Constants
-	glm::dvec2 xvec = glm::dvec2(attitudeHistory[pos-1][0],attitudeHistory[pos][0]);
-	glm::dvec2 yvec = glm::dvec2(attitudeHistory[pos-1][1],attitudeHistory[pos][1]);
-	glm::dvec2 zvec;
-	float PI = 3.1415926535;
-	// Yaw Correction (-pi to pi flippy plane)
-	if(attitudeHistory[pos-1][2]>0 && attitudeHistory[pos][2]<0) {
-		// Positive to negative
-		if(attitudeHistory[pos-1][2]>3 && attitudeHistory[pos][2]<-3) {
-			// pi to -pi flips
-			zvec = glm::dvec2(attitudeHistory[pos-1][2]-(2*PI),attitudeHistory[pos][2]);
-		} else {
-			// 0 to -0
-			zvec = glm::dvec2(attitudeHistory[pos-1][2],attitudeHistory[pos][2]);
-		}
-	} else if (attitudeHistory[pos-1][2]<0 && attitudeHistory[pos][2]>0) {
-		// Negative to positive
-		if(attitudeHistory[pos-1][2]<-3 && attitudeHistory[pos][2]>3) {
-			// -pi to pi flips
-			zvec = glm::dvec2(attitudeHistory[pos-1][2]+(2*PI),attitudeHistory[pos][2]);
-		} else {
-			// -0 to 0
-			zvec = glm::dvec2(attitudeHistory[pos-1][2],attitudeHistory[pos][2]);
-		}
-	} else {
-		// Same sign
-		zvec = glm::dvec2(attitudeHistory[pos-1][2],attitudeHistory[pos][2]);
-	}
-
-	xAttConst = xvec*inv;		// Flipped due to GLM ordering
-	yAttConst = yvec*inv;		// Flipped due to GLM ordering
-	zAttConst = zvec*inv;		// Flipped due to GLM ordering
+	}
 }
 
 /* Conversion Geodetic to ECEF */
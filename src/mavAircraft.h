@@ -16,17 +16,45 @@
 
 // Standard Includes
 #include <mutex>
+#include <memory>
+#include <cstdio>
 
 // Project Includes
 #include "model.h"
 #include "fonts.h"
-
-// Derived Class
-class MavAircraft : public Model {
+#include "telemetryState.h"
+#include "playbackClock.h"
+#include "latencyHistogram.h"
+#include "clockEstimator.h"
+#include "vehiclePool.h"
+#include "historyStore.h"
+#include "interpolationBatch.h"
+#include "settings.h"
+
+#define MAV_TRAIL_LENGTH			4096		// Points in the path plot, thinned as the flight grows
+#define MAV_DEBUG_INTERPOLATION		0			// 1 to record every interpolated frame for plotting (unbounded)
+
+// History columns
+#define HISTORY_POSITION			0			// (x,y,z) relative to origin
+#define HISTORY_VELOCITY			1			// (vx,vy,vz)
+#define HISTORY_ATTITUDE			0			// roll, pitch, yaw (rad)
+#define HISTORY_ATTITUDE_RATE		1
+
+
+/* Classes */
+// An aircraft drawn from telemetry. The model is shared, so aircraft with the same model file (and every
+// pool slot) load it once.
+class MavAircraft {
 public:
 	/* Data */
 	// Name
 	std::string name;
+	std::shared_ptr<Model> modelPt;
+
+	// Discovery Information
+	VehiclePool*		poolPt = nullptr;				// Pool the slot below belongs to, nullptr for aircraft in the config
+	VehicleSlot*		slotPt = nullptr;				// Pool slot followed by this aircraft
+	bool				active = true;					// False while a pool slot has no vehicle
 
 	// Position Information
 	glm::dvec3 			origin; 						// Lat (deg), Lon (deg), alt (km)
@@ -34,19 +62,17 @@ public:
 	glm::dvec3 			position; 						// (x,y,z) relative to origin
 	glm::dvec3 			velocity;						// (vx,vy,vz) (m/s)
 
-	// Position History Information
-	vector<glm::dvec3>	geoPositionHistory;				// Vector of Lat (deg), Lon (deg), alt (km)
-	vector<glm::dvec3>	positionHistory; 				// Vector of (x,y,z) relative to origin
-	vector<glm::dvec3>	velocityHistory;				// Vector of (vx,vy,vz)
-	vector<float>		timePositionHistory;			// Vector of floats corresponding to times of position history
+	// Position History Information, indexed by sample number
+	HistoryStore		positionHistory;				// Time, position and velocity columns
+	vector<glm::dvec3>	trailHistory;					// Thinned positions for the path plot, never reallocated
+	unsigned int		trailStride = 1;				// Position samples per trail point
+	unsigned int		trailSkipped = 0;				// Position samples since the last trail point
 	bool				firstPositionMessage = true;	// True if the first message has been received
 	unsigned int		currentPosMsgIndex = 0;			// Index of the 'latest' position mavlink message being displayed (this is behind the data)
 
 	// Attitude Information
 	glm::dvec3 			attitude;						// roll (rad), pitch (rad), yaw (rad)
-	vector<glm::dvec3>	attitudeHistory; 				// Vector if attiudes
-	vector<glm::dvec3>	attitudeRateHistory;			// Vector of attitude rates
-	vector<float>		timeAttitudeHistory;			// Vector of floats corresponding to times of attitude history
+	HistoryStore		attitudeHistory; 				// Time, attitude and attitude rate columns
 	bool				firstAttitudeMessage = true;	// True if the first message has been recieved
 	unsigned int		currentAttMsgIndex = 0; 		// Index of the 'latest' attitude mavlink message being displayed (behind the data)
 
@@ -55,25 +81,47 @@ public:
 	float				timeStartMavlink=0; 			// Boot time of the first mavlink message (s)
 	float				timeStartAtt=0;
 	float				timeStartMavlinkAtt=0;
-	float				timeDelay=0.3;  				// Delay between receiving the first mavlink message and displaying it (s)
+	float				timeDelay=0.1;  				// Delay between the estimated autopilot time and the displayed time (s)
 	float				currTime=0;						// The current time
 	float				dtPos=0;						// Timestep between current frame and last current position mavlink message time
 	float				dtAtt=0;						// Timestep between current frame and last current attitude mavlink message time
 	float				minDiff=10;						// Minimum difference between current sim time and time of latest mavlink message
-
-	// Interpolation Information
-	glm::dvec3 			xPosConst;
-	glm::dvec3 			yPosConst;
-	glm::dvec3 			zPosConst;
-	glm::dvec2			xAttConst;
-	glm::dvec2			yAttConst;
-	glm::dvec2			zAttConst;
+	double				displayTime=0;					// Autopilot time being displayed (s)
+	ClockEstimator		clockEstimator;					// Local to autopilot time, shared by the position and attitude streams
+
+	// Interpolation Segments, loaded from the history once per new window of samples
+	double				posSegmentTime[2];				// Start and end times (s)
+	glm::dvec3			posSegment[2];					// Start and end positions
+	glm::dvec3			velSegment[2];					// Start and end velocities, north, east, up
+	double				attSegmentTime[2];
+	glm::dvec4			attSegment[2];					// Start and end attitudes as unit quaternions
+	bool				posSegmentValid = false;		// True once the position segment ends at posSegmentIndex
+	unsigned int		posSegmentIndex = 0;			// History index the position segment ends at
+	bool				attSegmentValid = false;
+	unsigned int		attSegmentIndex = 0;
 
 	// Airpseed Information
 	float 				airspeed;						// (m/s)
 	float				heading;						// (rad)
 
-	// Temp stuff
+	// Telemetry Information
+	std::unique_ptr<TelemetryChannel> telemetry;		// Samples and state decoded by the socket thread
+	TelemetryState		state;							// Copy of the latest vehicle state, refreshed once per frame
+	uint32_t			stateVersion = 0;				// Version of the copy, changes whenever the state does
+	BusAircraft*		busPt = nullptr;				// Shared memory bus slot when viewing another process's ingest (-b)
+	uint64_t			busCursor = 0;					// Next sample to read from the bus ring
+	uint64_t			busLost = 0;					// Samples overwritten on the bus before this viewer read them
+	double				busClockOffset = 0;				// Ingest process clock to this process's clock (s)
+	uint32_t			latestVersion[TELEM_TYPE_COUNT] = {};	// Version of the last latest only sample taken, per type
+	uint64_t			latestOverwritten = 0;			// Latest only samples replaced before a frame took them
+
+	// Latency Information
+	bool				recordLatency = false;			// True to histogram ingest latencies (-l)
+	LatencyHistogram	visibleLatency;					// Datagram arrival to the sample being drained by the render thread
+	LatencyHistogram	drawnLatency;					// Datagram arrival to the end of the first frame drawn with the sample
+	vector<double>		pendingDrawArrivals;			// Arrival times of samples drained this frame
+
+	// Interpolated frames, recorded when MAV_DEBUG_INTERPOLATION is set
 	vector<float> tempTime;
 	vector<float> tempTime2;
 	vector<glm::dvec3> tempPos;
@@ -81,19 +129,32 @@ public:
 	vector<glm::dvec3> tempVel;
 
 	/* Constructor */
-	MavAircraft(const GLchar* path, glm::dvec3 origin, string name);
+	MavAircraft(std::shared_ptr<Model> modelPt, glm::dvec3 origin, string name);
 
 	/* Functions */
-	void updatePositionAttitude();
+	void attachSlot(VehiclePool* poolPt, VehicleSlot* slotPt);
+	void followSlot();
+	double silentTime();
+	void resetHistory();
+	void restartReplay();
+	void setHistoryRetention(historyDef position, historyDef attitude);
+	void enableHistorySpill(std::string directory);
+	void addTrailPoint(glm::dvec3 point);
+	void attachBus(BusAircraft* busPt, double clockOffset);
+	bool nextSample(TelemetrySample& sample);
+	bool isNewerSample(const TelemetrySample& sample);
+	void processTelemetry();
+	void applySample(const TelemetrySample& sample);
+	void recordFrameDrawn(double timeDrawn);
+	void updatePositionAttitude(InterpolationBatch& batch, size_t row);
+	void loadPositionSegment(InterpolationBatch& batch, size_t row);
+	void loadAttitudeSegment(InterpolationBatch& batch, size_t row);
+	void applyInterpolation(const InterpolationBatch& batch, size_t row);
 	void Draw(Shader shader);
-	void interpolatePosition();
-	void interpolateAttitude();
-	void calculatePositionInterpolationConstants();
-	void calculateAttitudeInterpolationConstants();
 
 	/* Conversions */
-	glm::dvec3 geo2ECEF(glm::dvec3 positionVector);
-	glm::dvec3 ecef2NEU(glm::dvec3 ecefVector, glm::dvec3 ecefOrigin, glm::dvec3 origin);
+	static glm::dvec3 geo2ECEF(glm::dvec3 positionVector);
+	static glm::dvec3 ecef2NEU(glm::dvec3 ecefVector, glm::dvec3 ecefOrigin, glm::dvec3 origin);
 
 };
 
@@ -0,0 +1,208 @@
+/*
+ * mavHandlers.cpp
+ */
+
+#include "mavHandlers.h"
+
+// Standard Includes
+#include <cstdio>
+#include <cmath>
+
+
+/* Global Registry */
+MavHandlerRegistry mavHandlerRegistry;
+
+/* Constructor */
+MavHandlerRegistry::MavHandlerRegistry() {
+	// Built in decoders
+	registerHandler(MAVLINK_MSG_ID_GLOBAL_POSITION_INT, handleGlobalPositionInt);
+	registerHandler(MAVLINK_MSG_ID_ATTITUDE, handleAttitude);
+	registerHandler(MAVLINK_MSG_ID_VFR_HUD, handleVfrHud);
+	registerHandler(MAVLINK_MSG_ID_SYSTEM_TIME, handleSystemTime);
+	registerHandler(MAVLINK_MSG_ID_TIMESYNC, handleTimesync);
+	registerHandler(MAVLINK_MSG_ID_HEARTBEAT, handleHeartbeat);
+	registerHandler(MAVLINK_MSG_ID_SYS_STATUS, handleSysStatus);
+	registerHandler(MAVLINK_MSG_ID_GPS_RAW_INT, handleGpsRawInt);
+	registerHandler(MAVLINK_MSG_ID_BATTERY_STATUS, handleBatteryStatus);
+}
+
+/* Functions */
+void MavHandlerRegistry::registerHandler(uint32_t msgid, MavHandler handler) {
+	// Installs (or replaces) the decoder for a msgid
+	uint32_t page = msgid >> MAV_HANDLER_PAGE_BITS;
+	if(page >= MAV_HANDLER_PAGES) {
+		printf("WARNING: Cannot register a handler for msgid %u.\n",msgid);
+		return;
+	}
+	if(!pages[page]) {
+		pages[page].reset(new MavHandler[1 << MAV_HANDLER_PAGE_BITS]());
+	}
+	pages[page][msgid & ((1 << MAV_HANDLER_PAGE_BITS) - 1)] = handler;
+}
+
+/* Handlers */
+void handleGlobalPositionInt(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived) {
+	// Setup Decoding Packet
+	mavlink_global_position_int_t packet;
+	mavlink_msg_global_position_int_decode(msg,&packet);
+
+	// Check for correct data
+	glm::dvec3 geoPos = glm::dvec3(packet.lat/1e7,packet.lon/1e7,packet.relative_alt/1e3);
+	if(geoPos[0]>=-90 && geoPos[0]<=90 && geoPos[1]>=-180 && geoPos[1]<=180 && geoPos[0]!=0 && geoPos[1]!=0) {
+		// Queue position and velocity
+		TelemetrySample sample;
+		sample.type = TELEM_POSITION;
+		sample.timeReceived = timeReceived;
+		sample.timeBoot = packet.time_boot_ms/1000.0;
+		sample.value = geoPos;
+		sample.rate = glm::dvec3(packet.vx/100.0,packet.vy/100.0,packet.vz/100.0);
+		channelPt->publish(sample);
+	} else {
+		printf("Waiting for correct data or GPS lock.\r");
+	}
+}
+
+void handleAttitude(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived) {
+	mavlink_attitude_t packet;
+	mavlink_msg_attitude_decode(msg,&packet);
+
+	// Queue rotations and rotation rates
+	TelemetrySample sample;
+	sample.type = TELEM_ATTITUDE;
+	sample.timeReceived = timeReceived;
+	sample.timeBoot = packet.time_boot_ms/1000.0;
+	sample.value = glm::dvec3(packet.roll,packet.pitch,-packet.yaw);
+	sample.rate = glm::dvec3(packet.rollspeed,packet.pitchspeed,-packet.yawspeed);
+	channelPt->publish(sample);
+}
+
+void handleVfrHud(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived) {
+	mavlink_vfr_hud_t packet;
+	mavlink_msg_vfr_hud_decode(msg,&packet);
+
+	// Store airspeed and heading
+	channelPt->writeState([&packet](TelemetryState& state) {
+		state.airspeed = packet.airspeed;
+		state.groundspeed = packet.groundspeed;
+		state.heading = packet.heading * M_PI / 180.0;
+		state.altitude = packet.alt;
+		state.climb = packet.climb;
+		state.throttle = packet.throttle;
+		state.fieldsValid |= TELEM_STATE_VFR_HUD;
+	});
+}
+
+void handleSystemTime(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived) {
+	// Autopilot boot time, ground stations send this message too
+	if(msg->compid != MAV_COMP_ID_AUTOPILOT1) {
+		return;
+	}
+	mavlink_system_time_t packet;
+	mavlink_msg_system_time_decode(msg,&packet);
+
+	// Queue clock observation
+	TelemetrySample sample;
+	sample.type = TELEM_CLOCK;
+	sample.timeReceived = timeReceived;
+	sample.timeBoot = packet.time_boot_ms/1000.0;
+	sample.value = glm::dvec3(0,0,0);
+	sample.rate = glm::dvec3(0,0,0);
+	channelPt->publish(sample);
+}
+
+void handleTimesync(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived) {
+	// A request from the autopilot (tc1 = 0) carries its own time in ts1 (ns). The viewer never
+	// transmits, so there is no round trip, the receive time gives the one way observation.
+	if(msg->compid != MAV_COMP_ID_AUTOPILOT1) {
+		return;
+	}
+	mavlink_timesync_t packet;
+	mavlink_msg_timesync_decode(msg,&packet);
+	if(packet.tc1 != 0 || packet.ts1 <= 0) {
+		return;
+	}
+
+	// Queue clock observation
+	TelemetrySample sample;
+	sample.type = TELEM_CLOCK;
+	sample.timeReceived = timeReceived;
+	sample.timeBoot = packet.ts1/1e9;
+	sample.value = glm::dvec3(0,0,0);
+	sample.rate = glm::dvec3(0,0,0);
+	channelPt->publish(sample);
+}
+
+void handleHeartbeat(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived) {
+	// Flight mode and state, ignoring heartbeats from ground stations and other components
+	if(msg->compid != MAV_COMP_ID_AUTOPILOT1) {
+		return;
+	}
+	mavlink_heartbeat_t packet;
+	mavlink_msg_heartbeat_decode(msg,&packet);
+
+	// Store mode
+	channelPt->writeState([&packet, timeReceived](TelemetryState& state) {
+		state.timeHeartbeat = timeReceived;
+		state.customMode = packet.custom_mode;
+		state.baseMode = packet.base_mode;
+		state.systemStatus = packet.system_status;
+		state.vehicleType = packet.type;
+		state.fieldsValid |= TELEM_STATE_HEARTBEAT;
+	});
+}
+
+void handleSysStatus(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived) {
+	mavlink_sys_status_t packet;
+	mavlink_msg_sys_status_decode(msg,&packet);
+
+	// Store sensor health, load and main battery
+	channelPt->writeState([&packet](TelemetryState& state) {
+		state.sensorsEnabled = packet.onboard_control_sensors_enabled;
+		state.sensorsHealth = packet.onboard_control_sensors_health;
+		state.load = packet.load;
+		if(!(state.fieldsValid & TELEM_STATE_BATTERY)) {
+			// BATTERY_STATUS takes over once it has been seen
+			state.batteryVoltage = packet.voltage_battery/1000.0;
+			state.batteryCurrent = (packet.current_battery >= 0) ? packet.current_battery/100.0 : -1;
+			state.batteryRemaining = packet.battery_remaining;
+		}
+		state.fieldsValid |= TELEM_STATE_SYS_STATUS;
+	});
+}
+
+void handleGpsRawInt(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived) {
+	mavlink_gps_raw_int_t packet;
+	mavlink_msg_gps_raw_int_decode(msg,&packet);
+
+	// Store fix quality
+	channelPt->writeState([&packet](TelemetryState& state) {
+		state.gpsFixType = packet.fix_type;
+		state.gpsSatellites = packet.satellites_visible;
+		state.gpsHdop = (packet.eph != UINT16_MAX) ? packet.eph/100.0 : -1;
+		state.fieldsValid |= TELEM_STATE_GPS;
+	});
+}
+
+void handleBatteryStatus(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived) {
+	mavlink_battery_status_t packet;
+	mavlink_msg_battery_status_decode(msg,&packet);
+	if(packet.id != 0) {
+		return;
+	}
+
+	// Pack voltage is the sum of the reported cells
+	float voltage = 0;
+	for(int i=0; i<10; i++) {
+		if(packet.voltages[i] != UINT16_MAX) {
+			voltage += packet.voltages[i]/1000.0;
+		}
+	}
+
+	// Store first battery
+	channelPt->writeState([&packet, voltage](TelemetryState& state) {
+		state.batteryVoltage = voltage;
+		state.batteryCurrent = (packet.current_battery >= 0) ? packet.current_battery/100.0 : -1;
+		state.batteryRemaining = packet.battery_remaining;
+		state.fieldsValid |= TELEM_STATE_BATTERY;
+	});
+}
@@ -0,0 +1,69 @@
+/*
+ * mavHandlers.h
+ */
+
+#ifndef MAVHANDLERS_H_
+#define MAVHANDLERS_H_
+
+// Standard Includes
+#include <cstdint>
+#include <memory>
+
+// Mavlink Includes
+#include <c_library_v2/ardupilotmega/mavlink.h>
+
+// Project Includes
+#include "telemetryState.h"
+
+#define MAV_HANDLER_PAGE_BITS	8						// Entries per page = 256
+#define MAV_HANDLER_PAGES		256						// Pages cover msgids 0 to 65535
+
+
+/* Types */
+// Decodes one message for one aircraft. Plain function pointer so dispatch is a table load and an indirect call.
+typedef void (*MavHandler)(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived);
+
+
+/* Classes */
+// Decoders indexed by msgid. Two level table: the high byte of the msgid selects a 256 entry page,
+// allocated only when a handler in that range is registered, so common MAVLink 1 ids share one page.
+// Handlers must be registered before the sockets start, lookups are then read only and lock free.
+class MavHandlerRegistry {
+public:
+	/* Constructor */
+	MavHandlerRegistry();
+
+	/* Functions */
+	void registerHandler(uint32_t msgid, MavHandler handler);
+
+	// Handler for a msgid, nullptr if nothing decodes it
+	MavHandler find(uint32_t msgid) const {
+		uint32_t page = msgid >> MAV_HANDLER_PAGE_BITS;
+		if(page >= MAV_HANDLER_PAGES || !pages[page]) {
+			return nullptr;
+		}
+		return pages[page][msgid & ((1 << MAV_HANDLER_PAGE_BITS) - 1)];
+	}
+
+private:
+	/* Data */
+	std::unique_ptr<MavHandler[]> pages[MAV_HANDLER_PAGES];
+};
+
+/* Handlers */
+void handleGlobalPositionInt(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived);
+void handleAttitude(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived);
+void handleVfrHud(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived);
+void handleSystemTime(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived);
+void handleTimesync(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived);
+void handleHeartbeat(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived);
+void handleSysStatus(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived);
+void handleGpsRawInt(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived);
+void handleBatteryStatus(const mavlink_message_t* msg, TelemetryChannel* channelPt, double timeReceived);
+
+/* Global Registry */
+// Shared by every socket and replay, holds the built in handlers on construction
+extern MavHandlerRegistry mavHandlerRegistry;
+
+
+#endif /* MAVHANDLERS_H_ */
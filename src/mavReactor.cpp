@@ -0,0 +1,48 @@
+/*
+ * mavReactor.cpp
+ */
+
+#include "mavReactor.h"
+
+
+/* Constructor */
+MavReactor::MavReactor(int numThreads) {
+	this->numThreads = numThreads;
+}
+
+/* Functions */
+void MavReactor::addSocket(MavSocket* mavSocketPt) {
+	// Binds the socket and queues its first read
+	mavSocketPt->openSocket(ioService);
+	sockets.push_back(mavSocketPt);
+}
+
+void MavReactor::start() {
+	// Keep the workers alive while no reads are pending
+	work.reset(new boost::asio::io_service::work(ioService));
+	for(int i=0; i<numThreads; i++) {
+		threads.push_back(std::thread([this]() {
+			try {
+				ioService.run();
+			} catch (std::exception& e) {
+				std::cerr << e.what() << std::endl;
+			}
+		}));
+	}
+	printf("Started MAVLink reactor: %i threads, %lu links\n",numThreads,(unsigned long)sockets.size());
+}
+
+void MavReactor::stop() {
+	// Cancels outstanding reads and waits for the workers to finish
+	work.reset();
+	ioService.stop();
+	for(unsigned int i=0; i<threads.size(); i++) {
+		threads[i].join();
+	}
+	threads.clear();
+
+	// Close sockets once no handler can be running
+	for(unsigned int i=0; i<sockets.size(); i++) {
+		sockets[i]->closeSocket();
+	}
+}
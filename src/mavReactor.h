@@ -0,0 +1,48 @@
+/*
+ * mavReactor.h
+ */
+
+#ifndef MAVREACTOR_H_
+#define MAVREACTOR_H_
+
+// Standard Includes
+#include <vector>
+#include <thread>
+#include <memory>
+
+// Boost Includes
+#include <boost/asio.hpp>
+
+// Project Includes
+#include "mavlinkReceive.h"
+
+// Number of threads servicing every link, independent of the number of aircraft
+#define MAV_REACTOR_THREADS 2
+
+
+/* Classes */
+// Owns a single io_service shared by every MavSocket. Each socket registers a read handler, so the
+// number of ingest threads stays fixed however many links are configured.
+class MavReactor {
+public:
+	/* Data */
+	boost::asio::io_service ioService;
+
+	/* Constructor */
+	MavReactor(int numThreads = MAV_REACTOR_THREADS);
+
+	/* Functions */
+	void addSocket(MavSocket* mavSocketPt);
+	void start();
+	void stop();
+
+private:
+	/* Data */
+	int numThreads;
+	std::unique_ptr<boost::asio::io_service::work> work;
+	std::vector<std::thread> threads;
+	std::vector<MavSocket*> sockets;
+};
+
+
+#endif /* MAVREACTOR_H_ */
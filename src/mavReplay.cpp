@@ -0,0 +1,181 @@
+/*
+ * mavReplay.cpp
+ */
+
+#include "mavReplay.h"
+
+// Standard Includes
+#include <algorithm>
+
+// System Includes
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Replay Pacing
+#define REPLAY_IDLE_SLEEP_MS	5		// Longest sleep while waiting for the next record (ms)
+#define REPLAY_CATCHUP_LAG		0.5		// Lag behind the clock treated as catching up after a seek (s)
+
+
+/* Constructor */
+MavReplay::MavReplay(std::string path, PlaybackClock* clockPt) : running(false), resetRequested(0), resetDone(0) {
+	this->path = path;
+	this->clockPt = clockPt;
+}
+
+MavReplay::~MavReplay() {
+	// Derived classes stop the thread before their state goes
+	stop();
+	if(data != nullptr) {
+		munmap((void*)data, size);
+	}
+}
+
+/* Functions */
+void MavReplay::start() {
+	running = true;
+	replayThread = std::thread(&MavReplay::replayLoop, this);
+}
+
+void MavReplay::stop() {
+	if(running) {
+		running = false;
+		replayThread.join();
+	}
+}
+
+bool MavReplay::resetPending() {
+	// True after a seek until the render thread has emptied the aircraft, nothing is replayed meanwhile
+	return resetRequested != resetDone;
+}
+
+void MavReplay::acknowledgeReset() {
+	// Called by the render thread once the aircraft hold nothing from before the seek
+	resetDone = resetRequested.load();
+}
+
+bool MavReplay::mapFile() {
+	// Map the whole file, pages are read in as the replay reaches them
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0) {
+		perror(("Could not open " + path).c_str());
+		return false;
+	}
+	struct stat fileStat;
+	fstat(fd, &fileStat);
+	size = fileStat.st_size;
+	if(size == 0) {
+		printf("ERROR: %s is empty.\n", path.c_str());
+		close(fd);
+		return false;
+	}
+	void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapped == MAP_FAILED) {
+		perror(("Could not map " + path).c_str());
+		return false;
+	}
+	madvise(mapped, size, MADV_SEQUENTIAL);
+	data = (const uint8_t*)mapped;
+	releasedOffset = 0;
+	return true;
+}
+
+void MavReplay::releaseBefore(size_t at) {
+	// Drops replayed pages so a long recording doesn't stay resident, they are read back if needed
+	if(at < releasedOffset + REPLAY_RELEASE_LENGTH) {
+		return;
+	}
+	size_t pageSize = sysconf(_SC_PAGESIZE);
+	size_t end = at & ~(pageSize - 1);
+	madvise((void*)(data + releasedOffset), end - releasedOffset, MADV_DONTNEED);
+	releasedOffset = end;
+}
+
+void MavReplay::releaseAll() {
+	// Drops every page, used after scanning a file before the replay starts from the beginning
+	madvise((void*)data, size, MADV_DONTNEED);
+	releasedOffset = 0;
+}
+
+bool MavReplay::indexRecord(uint64_t timeUsec, size_t at) {
+	// Adds a seek point for the record at an offset if it is far enough past the last, true if added
+	if(!seekIndex.empty() && timeUsec < seekIndex.back().timeUsec + (uint64_t)(REPLAY_SEEK_SPACING*1e6)) {
+		return false;
+	}
+	seekIndex.push_back({timeUsec, at});
+	return true;
+}
+
+void MavReplay::seekTo(double time) {
+	// Moves to the last seek point at or before time, the records from there up to time then replay
+	// catching up. Pages around the old position are dropped.
+	if(seekIndex.empty()) {
+		return;
+	}
+	uint64_t timeUsec = firstTimeUsec + (uint64_t)(std::max(time, 0.0)*1e6);
+	size_t point = std::upper_bound(seekIndex.begin(), seekIndex.end(), timeUsec,
+			[](uint64_t t, const ReplaySeekPoint& seekPoint) { return t < seekPoint.timeUsec; }) - seekIndex.begin();
+	if(point > 0) {
+		point--;
+	}
+	releaseAll();
+	seekToPoint(point);
+	size_t pageSize = sysconf(_SC_PAGESIZE);
+	releasedOffset = seekIndex[point].offset & ~(pageSize - 1);
+}
+
+void MavReplay::replayLoop() {
+	ReplayRecord record;
+	uint32_t seeksHandled = clockPt->seekCount();
+	while(running) {
+		// Seek, then wait for the render thread to drop what was replayed from the old position
+		uint32_t seeks = clockPt->seekCount();
+		if(seeks != seeksHandled) {
+			seeksHandled = seeks;
+			seekTo(clockPt->now());
+			resetRequested++;
+		}
+		if(resetPending()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		// Wait for the aircraft to catch up with what has been queued. While paused the clock stands
+		// still, so only the records up to it (after a seek) are replayed.
+		if((clockPt->isPaused() && clockPt->asFastAsPossible()) || backlogged()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		// End of file, hold the last state
+		if(!peekRecord(&record)) {
+			clockPt->catchingUp = false;
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			continue;
+		}
+		// Records stamped before the first (out of order interfaces in pcapng) are due straight away
+		double recordTime = std::max((int64_t)(record.timeUsec - firstTimeUsec), (int64_t)0)/1e6;
+
+		// Emit records that are due
+		bool fast = clockPt->asFastAsPossible();
+		double now = clockPt->now();
+		if(fast || recordTime <= now) {
+			record.socketPt->processDatagram(record.data, record.length, record.senderKey, recordTime, record.timeUsec);
+			consumeRecord();
+			replayedFrames++;
+			if(fast) {
+				clockPt->advanceTo(recordTime);
+			} else {
+				clockPt->catchingUp = (now - recordTime) > REPLAY_CATCHUP_LAG;
+			}
+		} else {
+			// Sleep until the next record is due
+			clockPt->catchingUp = false;
+			double wait = (recordTime - now)/clockPt->getSpeed();
+			int waitMs = std::min((int)(wait*1000.0), REPLAY_IDLE_SLEEP_MS);
+			std::this_thread::sleep_for(std::chrono::milliseconds(std::max(waitMs, 1)));
+		}
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ * mavReplay.h
+ */
+
+#ifndef MAVREPLAY_H_
+#define MAVREPLAY_H_
+
+// Standard Includes
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Project Includes
+#include "mavlinkReceive.h"
+#include "playbackClock.h"
+
+#define REPLAY_RELEASE_LENGTH	(64 << 20)	// Replayed bytes dropped from the page cache at a time
+#define REPLAY_SEEK_SPACING		1.0			// Recorded time between seek index points (s)
+
+
+/* Structures */
+// One datagram (or frame) from a recording and the link it belongs to
+struct ReplayRecord {
+	uint64_t		timeUsec;				// Recorded receive time (unix us)
+	const uint8_t*	data;
+	size_t			length;
+	MavSocket*		socketPt;
+	uint64_t		senderKey;				// Selects the parser, as the sender address does for live links
+};
+
+// Place in a recording a seek can restart from
+struct ReplaySeekPoint {
+	uint64_t		timeUsec;				// Recorded receive time of the record at offset (unix us)
+	size_t			offset;
+};
+
+/* Classes */
+// Base for recorded telemetry sources. Owns the memory mapped file and the thread that feeds records
+// through each link's parse and decode path, paced by the playback clock. Files are read in place and
+// pages behind the replay are released, so recordings larger than memory stream through. A seek moves
+// the replay to the indexed record before the new time and has the render thread empty the aircraft,
+// so the whole recording can be seeked through, not just the history the aircraft still hold.
+class MavReplay {
+public:
+	/* Data */
+	std::string path;
+	double duration = 0;					// Time between the first and last record (s)
+	uint64_t replayedFrames = 0;
+
+	/* Constructor */
+	MavReplay(std::string path, PlaybackClock* clockPt);
+	virtual ~MavReplay();
+
+	/* Functions */
+	virtual bool openFile() = 0;
+	void start();
+	void stop();
+	bool resetPending();
+	void acknowledgeReset();
+
+protected:
+	/* Data */
+	PlaybackClock* clockPt;
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+	uint64_t firstTimeUsec = 0;
+	std::vector<ReplaySeekPoint> seekIndex;	// Built by openFile, in file order
+
+	/* Functions */
+	bool mapFile();
+	void releaseBefore(size_t at);
+	void releaseAll();
+	bool indexRecord(uint64_t timeUsec, size_t at);
+	// Moves the replay position to seekIndex[point]
+	virtual void seekToPoint(size_t point) = 0;
+	// Record at the replay position without consuming it, false at the end of the file
+	virtual bool peekRecord(ReplayRecord* record) = 0;
+	virtual void consumeRecord() = 0;
+	// True while the aircraft haven't taken what has already been replayed
+	virtual bool backlogged() = 0;
+
+private:
+	/* Data */
+	std::atomic<bool> running;
+	std::thread replayThread;
+	size_t releasedOffset = 0;
+	std::atomic<uint32_t> resetRequested;	// Seeks that need the aircraft emptied
+	std::atomic<uint32_t> resetDone;		// Seeks the render thread has emptied the aircraft for
+
+	/* Functions */
+	void replayLoop();
+	void seekTo(double time);
+};
+
+
+#endif /* MAVREPLAY_H_ */
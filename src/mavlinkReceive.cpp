@@ -8,155 +8,392 @@
 #include "mavlinkReceive.h"
 
 /* Constructor */
-MavSocket::MavSocket(string host, string port, MavAircraft* mavAircraftPt) {
+MavParser::MavParser() {
+	// Start in the uninitialised state, as the static channel buffers do
+	memset(&rxMsg, 0, sizeof(rxMsg));
+	memset(&rxStatus, 0, sizeof(rxStatus));
+	skipping = false;
+	frameUsed = 0;
+}
+
+/* Functions */
+bool MavParser::parseChar(uint8_t c, mavlink_message_t* msg, LinkHealth* health) {
+	// Mirrors mavlink_parse_char, using this parser's buffers instead of a shared channel
+	mavlink_status_t status;
+	bool wasIdle = rxStatus.parse_state <= MAVLINK_PARSE_STATE_IDLE;
+
+	// Keep the received bytes of the frame, so it can be recorded exactly as it arrived
+	if(wasIdle) {
+		frameUsed = 0;
+	}
+	if(frameUsed < MAVLINK_MAX_PACKET_LEN) {
+		frame[frameUsed++] = c;
+	}
+	uint8_t result = mavlink_frame_char_buffer(&rxMsg, &rxStatus, c, msg, &status);
+
+	// Count each run of bytes that isn't part of a frame once
+	if(wasIdle && rxStatus.parse_state <= MAVLINK_PARSE_STATE_IDLE && result == MAVLINK_FRAMING_INCOMPLETE) {
+		if(!skipping && health != nullptr) {
+			health->parseErrors.add();
+		}
+		skipping = true;
+	} else {
+		skipping = false;
+	}
+
+	if(result == MAVLINK_FRAMING_BAD_CRC || result == MAVLINK_FRAMING_BAD_SIGNATURE) {
+		// Count against the link
+		if(health != nullptr) {
+			if(result == MAVLINK_FRAMING_BAD_CRC) {
+				health->crcErrors.add();
+			} else {
+				health->parseErrors.add();
+			}
+		}
+
+		// Treat as a parse failure and resynchronise this stream only
+		rxStatus.parse_error++;
+		rxStatus.msg_received = MAVLINK_FRAMING_INCOMPLETE;
+		rxStatus.parse_state = MAVLINK_PARSE_STATE_IDLE;
+		frameUsed = 0;
+		if(c == MAVLINK_STX) {
+			rxStatus.parse_state = MAVLINK_PARSE_STATE_GOT_STX;
+			rxMsg.len = 0;
+			mavlink_start_checksum(&rxMsg);
+			frame[frameUsed++] = c;
+		}
+		return false;
+	}
+	return result == MAVLINK_FRAMING_OK;
+}
+
+const uint8_t* MavParser::frameData() const {
+	// Bytes of the frame parseChar last completed, valid until the next call
+	return frame;
+}
+
+size_t MavParser::frameLength() const {
+	return frameUsed;
+}
+
+/* Constructor */
+MavSocket::MavSocket(string host, string port, TelemetryChannel* defaultChannelPt) : wakeupLatency("port" + port + "/kernel_to_user"), health(new LinkHealth()),
+		filter(new IngestFilter()), poolPt(nullptr), lastSweepTime(0) {
 	this->host = host;
 	this->port = port;
-	this->mavAircraftPt = mavAircraftPt;
+	this->defaultChannelPt = defaultChannelPt;
+	std::fill(discovered, discovered + 256, nullptr);
+	std::fill(refusedWarned, refusedWarned + 256, false);
 }
 
 /* Functions */
-void MavSocket::startSocket() {
+void MavSocket::enableRecording(string directory) {
+	// Records every frame received on this socket to a tlog
+	recorder.reset(new TlogRecorder(directory, "port" + port));
+}
+
+void MavSocket::addForward(string ipString, int port) {
+	// Passes every datagram received on this socket on to another UDP endpoint
+	if(!forwarder) {
+		forwarder.reset(new DatagramForwarder());
+	}
+	if(forwarder->addDestination(ipString, port)) {
+		printf("Socket %s: forwarding to %s:%i\n",this->port.c_str(),ipString.c_str(),port);
+	}
+}
+
+void MavSocket::setIngestPolicy(string message, string policy) {
+	// Thins or coalesces a message type on this socket before it is decoded
+	if(filter->setPolicy(message, policy)) {
+		printf("Socket %s: %s ingest policy %s\n",port.c_str(),message.c_str(),policy.c_str());
+	}
+}
+
+void MavSocket::addRoute(uint8_t sysid, uint8_t compid, TelemetryChannel* channelPt) {
+	// Routes messages from a vehicle on this port to an aircraft's channel, compid 0 matches any component
+	uint16_t key = (sysid << 8) | compid;
+	if(routes.count(key) > 0) {
+		printf("WARNING: Socket %s already routes sysid %i, compid %i, replacing.\n",port.c_str(),sysid,compid);
+	}
+	routes[key] = channelPt;
+}
+
+TelemetryChannel* MavSocket::findRoute(uint8_t sysid, uint8_t compid) {
+	// Exact component first, then any component of the system, then the socket default
+	if(!routes.empty()) {
+		std::unordered_map<uint16_t, TelemetryChannel*>::iterator it = routes.find((sysid << 8) | compid);
+		if(it != routes.end()) {
+			return it->second;
+		}
+		it = routes.find(sysid << 8);
+		if(it != routes.end()) {
+			return it->second;
+		}
+	}
+	if(discovered[sysid] != nullptr) {
+		return discovered[sysid]->channelPt;
+	}
+	return defaultChannelPt;
+}
+
+void MavSocket::setVehiclePool(VehiclePool* poolPt) {
+	// Gives vehicles that aren't in the config a pool slot when their first heartbeat arrives
+	this->poolPt = poolPt;
+}
+
+void MavSocket::trackVehicle(const mavlink_message_t* msg, double timeReceived) {
+	// Claims pool slots for new vehicles and drops the routes of slots the render thread is retiring
+	poolPt->lastIngest.set(std::max(poolPt->lastIngest.get(), timeReceived));
+
+	// Release slots that went quiet for good, before a new vehicle looks for one
+	if(timeReceived - lastSweepTime > VEHICLE_SWEEP_PERIOD) {
+		sweepVehicles(timeReceived);
+	}
+
+	VehicleSlot*& slotPt = discovered[msg->sysid];
+	if(slotPt != nullptr && slotPt->status.load(std::memory_order_acquire) == VEHICLE_SLOT_RETIRING) {
+		// Back before the render thread took the slot, it starts again in a new one
+		poolPt->acknowledge(slotPt);
+		slotPt = nullptr;
+	}
+	if(slotPt == nullptr && msg->msgid == MAVLINK_MSG_ID_HEARTBEAT && routes.count(msg->sysid << 8) == 0) {
+		// Only autopilots, not ground stations, gimbals or companion computers
+		mavlink_heartbeat_t heartbeat;
+		mavlink_msg_heartbeat_decode(msg, &heartbeat);
+		if(heartbeat.type != MAV_TYPE_GCS && heartbeat.autopilot != MAV_AUTOPILOT_INVALID) {
+			slotPt = poolPt->claim(msg->sysid, timeReceived);
+			if(slotPt != nullptr) {
+				printf("Socket %s: discovered sysid %i\n",port.c_str(),msg->sysid);
+				refusedWarned[msg->sysid] = false;
+			} else {
+				if(!refusedWarned[msg->sysid]) {
+					printf("WARNING: Socket %s: vehicle pool full, sysid %i not shown.\n",port.c_str(),msg->sysid);
+					refusedWarned[msg->sysid] = true;
+				}
+				// Hand retiring slots back now, so the render thread frees them before the next heartbeat
+				sweepVehicles(timeReceived);
+			}
+		}
+	}
+	if(slotPt != nullptr) {
+		slotPt->lastSeen.set(timeReceived);
+	}
+}
+
+void MavSocket::sweepVehicles(double timeReceived) {
+	// Acknowledges slots the render thread is retiring, dropping their routes
+	for(int i=0; i<256; i++) {
+		if(discovered[i] != nullptr && poolPt->acknowledge(discovered[i])) {
+			printf("Socket %s: retired sysid %i\n",port.c_str(),i);
+			discovered[i] = nullptr;
+		}
+	}
+	lastSweepTime = timeReceived;
+}
+
+void MavSocket::openSocket(boost::asio::io_service& ioService) {
 	try {
 		/* Creates the socket to connect to an Mavlink stream */
-		boost::asio::io_service io_service;
 		udp::endpoint local_endpoint = boost::asio::ip::udp::endpoint(
 		boost::asio::ip::address::from_string(this->host), boost::lexical_cast<int>(this->port));
 		std::cout << "Bound socket: " << local_endpoint << std::endl;
 
 		// Create Socket
-		udp::socket socket(io_service, udp::endpoint(udp::v4(), boost::lexical_cast<int>(this->port)));
+		socket.reset(new udp::socket(ioService, udp::endpoint(udp::v4(), boost::lexical_cast<int>(this->port))));
+
+		// Enlarge the kernel receive buffer so bursts from many vehicles queue rather than drop
+		socket->set_option(boost::asio::socket_base::receive_buffer_size(MAV_UDP_RECEIVE_BUFFER));
+
+		// Reads are driven by the reactor, the batch receive must never block a worker
+		socket->non_blocking(true);
+
+		// Stamp datagrams on arrival in the kernel, so ingest thread scheduling doesn't shift sample times
+		DatagramBatch::enableTimestamps(socket->native_handle());
 
 		// Setup Buffers
-		boost::array<char, 128> recv_buf;
-		udp::endpoint sender_endpoint;
-
-		// Receive Mavlink
-		while (this->socketRunning) {
-			// Receive Data
-			size_t len = socket.receive_from(boost::asio::buffer(recv_buf), sender_endpoint);
-			// Setup Message Buffers
-			mavlink_message_t msg;
-			mavlink_status_t status;
-
-			// Parse buffer
-			if(this->mavAircraftPt!=nullptr) {
-				for(size_t i=0; i < len; i++) {
-					if(mavlink_parse_char(MAVLINK_COMM_0, recv_buf[i], &msg, &status)) {
-						// Message was recieved
-						switch(msg.msgid) {
-							case MAVLINK_MSG_ID_GLOBAL_POSITION_INT: {
-								// Setup Decoding Packet
-								mavlink_global_position_int_t packet;
-								mavlink_msg_global_position_int_decode(&msg,&packet);
-
-								// Check for correct data
-								glm::dvec3 geoPos = glm::dvec3(packet.lat/1e7,packet.lon/1e7,packet.relative_alt/1e3);
-								if(geoPos[0]>=-90 && geoPos[0]<=90 && geoPos[1]>=-180 && geoPos[1]<=180 && geoPos[0]!=0 && geoPos[1]!=0) {
-
-									// First Message
-									if(mavAircraftPt->firstPositionMessage) {
-										mavAircraftPt->timeStart = glfwGetTime();
-										mavAircraftPt->timeStartMavlink = packet.time_boot_ms/1000.0;
-										printf("%s: Our Position Start Time: %f, Mavlink Start Time: %f\n",mavAircraftPt->name.c_str(),mavAircraftPt->timeStart,mavAircraftPt->timeStartMavlink);
-									}
-
-									// Store GeoPosition
-									(mavAircraftPt->geoPositionHistory).push_back(geoPos);
-									(mavAircraftPt)->geoPosition = geoPos;
-
-									/* Convert Geodetic to ECEF */
-									glm::dvec3 ecefPosition = mavAircraftPt->geo2ECEF(mavAircraftPt->geoPosition);
-									glm::dvec3 ecefOrigin = mavAircraftPt->geo2ECEF(mavAircraftPt->origin);
-
-									/* Convert from ECEF to NEU */
-									glm::dvec3 pos = mavAircraftPt->ecef2NEU(ecefPosition, ecefOrigin, mavAircraftPt->origin);
-									mavAircraftPt->positionHistory.push_back(pos);
-									if(mavAircraftPt->firstPositionMessage) {
-										mavAircraftPt->position = mavAircraftPt->positionHistory[0];
-									}
-
-									// Store velocities to enforce end position
-									if(mavAircraftPt->positionHistory.size() > 1) {
-										glm::dvec3 vel = glm::dvec3(packet.vx/100.0,packet.vy/100.0,packet.vz/100.0);
-										mavAircraftPt->velocity = vel;
-										mavAircraftPt->velocityHistory.push_back(vel);
-
-									} else {
-										// Store first position and time
-										mavAircraftPt->position = mavAircraftPt->positionHistory[0];
-										mavAircraftPt->currTime = glfwGetTime() - mavAircraftPt->timeStart;
-									}
-
-									// Store Time
-									mavAircraftPt->timePositionHistory.push_back(packet.time_boot_ms/1000.0);
-
-									// Toggle after recieving first message
-									if(mavAircraftPt->firstPositionMessage) {
-										(mavAircraftPt)->firstPositionMessage = false;
-									}
-								} else {
-									printf("Waiting for correct data or GPS lock.\r");
-								}
-
-								break;
-							}
-							case MAVLINK_MSG_ID_ATTITUDE: {
-								mavlink_attitude_t packet;
-								mavlink_msg_attitude_decode(&msg,&packet);
-
-								// First Message
-								if(mavAircraftPt->firstAttitudeMessage) {
-									(mavAircraftPt)->timeStartAtt = glfwGetTime();
-									(mavAircraftPt)->timeStartMavlinkAtt = packet.time_boot_ms/1000.0;
-									printf("%s: Our Attitude Start Time: %f, Mavlink Start Time: %f\n",mavAircraftPt->name.c_str(),mavAircraftPt->timeStartAtt,mavAircraftPt->timeStartMavlinkAtt);
-								}
-
-								// Store Rotations
-								glm::vec3 rot = glm::vec3(packet.roll,packet.pitch,-packet.yaw);
-								mavAircraftPt->attitude = rot;
-								mavAircraftPt->attitudeHistory.push_back(rot);
-
-								// Store Rotation Rates
-								glm::dvec3 rotRate = glm::dvec3(packet.rollspeed,packet.pitchspeed,-packet.yawspeed);
-								mavAircraftPt->attitudeRateHistory.push_back(rotRate);
-								// Store Time
-								mavAircraftPt->timeAttitudeHistory.push_back(packet.time_boot_ms/1000.0);
-
-								// Reset First Message Switch
-								if(mavAircraftPt->firstAttitudeMessage) {
-									mavAircraftPt->firstAttitudeMessage = false;
-								}
-
-								break;
-							}
-							case MAVLINK_MSG_ID_VFR_HUD: {
-								mavlink_vfr_hud_t packet;
-								mavlink_msg_vfr_hud_decode(&msg,&packet);
-
-								// Store airspeed
-								mavAircraftPt->airspeed = packet.airspeed;
-								mavAircraftPt->heading = packet.heading * M_PI / 180.0;
-							}
-
-						}
+		batch.reset(new DatagramBatch());
+		stats.lastReportTime = playbackClock.now();
+
+		// Queue first read
+		waitForData();
+
+	}  catch (std::exception& e)  {
+		// Error
+			std::cerr << e.what() << std::endl;
+	}
+}
+
+void MavSocket::waitForData() {
+	// Wait for the socket to become readable, without consuming anything
+	socket->async_receive(boost::asio::null_buffers(), [this](const boost::system::error_code& error, size_t) {
+		handleReadable(error);
+	});
+}
+
+void MavSocket::handleReadable(const boost::system::error_code& error) {
+	// Stop on cancellation or shutdown
+	if(error) {
+		if(error != boost::asio::error::operation_aborted) {
+			std::cerr << "Socket " << port << ": " << error.message() << std::endl;
+		}
+		return;
+	}
+
+	// Drain a bounded number of batches so one busy link can't starve the others
+	for(int n=0; n<MAV_BATCHES_PER_WAKEUP; n++) {
+		if(batch->receive(socket->native_handle(), &stats) < 0) {
+			if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				perror("recvmmsg");
+			}
+			break;
+		}
+		double timeProcessed = playbackClock.now();
+		uint64_t realtimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+		// Parse buffers
+		for(int j=0; j<batch->count; j++) {
+			const sockaddr_in& sender = batch->sender(j);
+			uint64_t senderKey = ((uint64_t)sender.sin_addr.s_addr << 16) | sender.sin_port;
+
+			// Move the kernel receive time (CLOCK_REALTIME) into the playback clock by its age
+			double timeReceived = timeProcessed;
+			uint64_t timeUnixUsec = realtimeNs/1000;
+			uint64_t kernelNs = batch->kernelTimeNs(j);
+			if(kernelNs != 0 && kernelNs <= realtimeNs && (realtimeNs - kernelNs)/1e9 < MAV_MAX_TIMESTAMP_AGE) {
+				timeReceived = timeProcessed - (realtimeNs - kernelNs)/1e9;
+				timeUnixUsec = kernelNs/1000;
+				wakeupLatency.record((realtimeNs - kernelNs)/1000);
+			}
+			processDatagram(batch->data(j), batch->length(j), senderKey, timeReceived, timeUnixUsec);
+		}
+
+		// Forward the raw datagrams once local decode is done
+		if(forwarder) {
+			forwarder->forward(batch.get());
+		}
+
+		// Report ingest rates
+		if(timeProcessed - stats.lastReportTime > MAV_STATS_REPORT_PERIOD) {
+			reportStats(timeProcessed);
+		}
+
+		// Socket is empty
+		if(batch->count < MAV_UDP_BATCH_SIZE) {
+			break;
+		}
+	}
+
+	// Queue next read
+	waitForData();
+}
+
+void MavSocket::processDatagram(const uint8_t* data, size_t len, uint64_t senderKey, double timeReceived, uint64_t timeUnixUsec) {
+	// Parses a datagram from a socket or replay and passes each message on
+	MavParser& parser = parsers[senderKey];
+	for(size_t i=0; i < len; i++) {
+		if(parser.parseChar(data[i], &msg, health.get())) {
+			// Sequence and loss counters
+			health->countMessage(msg.sysid, msg.compid, msg.seq);
 
+			// Vehicle discovery
+			if(poolPt != nullptr) {
+				trackVehicle(&msg, timeReceived);
+			}
 
+			// Record the raw frame
+			if(recorder) {
+				recorder->writeFrame(timeUnixUsec, parser.frameData(), parser.frameLength());
+			}
 
+			// Message was recieved, decode it for the aircraft with this sysid/compid
+			MavHandler handler = mavHandlerRegistry.find(msg.msgid);
+			if(handler != nullptr) {
+				TelemetryChannel* targetPt = findRoute(msg.sysid, msg.compid);
+				if(targetPt!=nullptr) {
+					IngestAction action = filter->admit(&msg, timeReceived);
+					if(action != INGEST_DROP) {
+						targetPt->latestOnly = (action == INGEST_PUBLISH_LATEST);
+						handler(&msg, targetPt, timeReceived);
+						targetPt->latestOnly = false;
 					}
 				}
 			}
+		}
+	}
+}
 
+bool MavSocket::backlogged() {
+	// True if any aircraft fed by this socket has a mostly full queue, used to pace replays
+	std::unordered_map<uint16_t, TelemetryChannel*>::iterator it;
+	for(it = routes.begin(); it != routes.end(); it++) {
+		if(it->second->queue.size() > TELEMETRY_QUEUE_LENGTH*3/4) {
+			return true;
+		}
+	}
+	for(int i=0; i<256; i++) {
+		if(discovered[i] != nullptr && discovered[i]->channelPt->queue.size() > TELEMETRY_QUEUE_LENGTH*3/4) {
+			return true;
 		}
-		// Close Socket
-		socket.close();
+	}
+	return defaultChannelPt != nullptr && defaultChannelPt->queue.size() > TELEMETRY_QUEUE_LENGTH*3/4;
+}
 
+void MavSocket::reportStats(double currentTime) {
+	// Prints datagram and syscall rates since the last report
+	double dt = currentTime - stats.lastReportTime;
+	double datagramRate = (stats.datagrams.get() - stats.lastDatagrams) / dt;
+	double syscallRate = (stats.syscalls.get() - stats.lastSyscalls) / dt;
+	printf("Socket %s: %.1f datagrams/s, %.1f syscalls/s, %.2f datagrams/syscall, %lu truncated\n",port.c_str(),datagramRate,syscallRate,
+			syscallRate > 0 ? datagramRate/syscallRate : 0.0,(unsigned long)stats.truncated.get());
+	printf("Socket %s: %lu messages, %.2f%% lost, %lu reordered, %lu crc errors, %lu parse errors\n",port.c_str(),(unsigned long)health->messages.get(),
+			health->lossPercent(),(unsigned long)health->reordered.get(),(unsigned long)health->crcErrors.get(),(unsigned long)health->parseErrors.get());
+	if(wakeupLatency.count() > 0) {
+		printf("Socket %s: kernel to user p50 %lu us, p99 %lu us, max %lu us, %lu unstamped\n",port.c_str(),(unsigned long)wakeupLatency.percentile(50),
+				(unsigned long)wakeupLatency.percentile(99),(unsigned long)wakeupLatency.percentile(100),(unsigned long)stats.unstamped.get());
+	}
+	if(forwarder) {
+		forwarder->report(port);
+	}
+	filter->report(port);
+	if(recorder) {
+		printf("Socket %s: %lu frames recorded, %lu dropped\n",port.c_str(),(unsigned long)recorder->recordedFrames,(unsigned long)recorder->droppedFrames);
+	}
 
-	}  catch (std::exception& e)  {
-		// Error
-			std::cerr << e.what() << std::endl;
+	// Store for next report
+	stats.lastReportTime = currentTime;
+	stats.lastDatagrams = stats.datagrams.get();
+	stats.lastSyscalls = stats.syscalls.get();
+	wakeupLatency.reset();
+}
+
+void MavSocket::updateRates(double currentTime) {
+	// Packet and byte rates since the last call. Run by the reader on its own tick rather than by the
+	// ingest when data arrives, so a link that stops reads 0 instead of its last rate.
+	uint64_t datagrams = stats.datagrams.get();
+	uint64_t bytes = stats.bytes.get();
+	double dt = currentTime - stats.rateTime;
+	if(stats.rateTime >= 0 && dt > 0) {
+		stats.datagramRate.set((datagrams - stats.rateDatagrams) / dt);
+		stats.byteRate.set((bytes - stats.rateBytes) / dt);
 	}
+	stats.rateTime = currentTime;
+	stats.rateDatagrams = datagrams;
+	stats.rateBytes = bytes;
+}
+
+void MavSocket::writeHealthJson(FILE* file, double currentTime) {
+	// Exports the link counters, safe to call from any thread
+	fprintf(file,"{\"link\":\"port%s\",\"time\":%.3f,\"datagrams\":%llu,\"bytes\":%llu,\"datagram_rate\":%.1f,\"byte_rate\":%.1f}\n",
+			port.c_str(), currentTime, (unsigned long long)stats.datagrams.get(), (unsigned long long)stats.bytes.get(),
+			stats.datagramRate.get(), stats.byteRate.get());
+	health->writeJson(file, "port" + port, currentTime);
+	filter->writeJson(file, "port" + port, currentTime);
 }
 
 void MavSocket::closeSocket() {
-	this->socketRunning = false;
+	// Only called once the reactor has stopped
+	if(socket) {
+		boost::system::error_code ec;
+		socket->close(ec);
+	}
 }
@@ -16,25 +16,105 @@ using boost::asio::ip::udp;
 // Mavlink Includes
 #include <c_library_v2/ardupilotmega/mavlink.h>
 #define MAV_INCOMING_BUFFER_LENGTH 2041
+#define MAV_UDP_RECEIVE_BUFFER 1048576		// Kernel socket receive buffer (bytes)
+#define MAV_STATS_REPORT_PERIOD 5.0			// Time between ingest rate reports (s)
+#define MAV_RATE_UPDATE_PERIOD 1.0			// Time between link rate updates by the render thread (s)
+#define MAV_BATCHES_PER_WAKEUP 4			// Batches drained per readable event before yielding to other links
+#define MAV_MAX_TIMESTAMP_AGE 1.0			// Kernel timestamps older than this are treated as clock steps (s)
+
+// Standard Includes
+#include <iostream>
+#include <string>
+#include <memory>
+#include <cerrno>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+using std::string;
 
 // Project Includes
-#include "mavAircraft.h"
+#include "telemetryState.h"
+#include "mavHandlers.h"
+#include "datagramBatch.h"
+#include "datagramForwarder.h"
+#include "tlogRecorder.h"
+#include "playbackClock.h"
+#include "latencyHistogram.h"
+#include "linkHealth.h"
+#include "ingestPolicy.h"
+#include "vehiclePool.h"
+
+
+/* Classes */
+// Framing state for one incoming byte stream. Replaces the shared MAVLINK_COMM_n channel buffers so
+// interleaved streams can't corrupt each other, and there is no limit on the number of streams.
+class MavParser {
+public:
+	/* Constructor */
+	MavParser();
 
+	/* Functions */
+	bool parseChar(uint8_t c, mavlink_message_t* msg, LinkHealth* health = nullptr);
+	const uint8_t* frameData() const;
+	size_t frameLength() const;
+
+private:
+	/* Data */
+	mavlink_message_t rxMsg;
+	mavlink_status_t rxStatus;
+	bool skipping;									// True while discarding bytes outside a frame
+	uint8_t frame[MAVLINK_MAX_PACKET_LEN];			// Bytes of the frame being parsed, as received
+	size_t frameUsed;
+};
 
 class MavSocket {
 public:
-	bool socketRunning = true;
 	string host;
 	string port;
-	MavAircraft* mavAircraftPt;
+	TelemetryChannel* defaultChannelPt;					// Receives messages from any sysid without a route
+	IngestStats stats;
+	LatencyHistogram wakeupLatency;					// Kernel receive timestamp to user space processing, per report period
+	std::unique_ptr<LinkHealth> health;				// Message counts, errors and sequence loss, readable from the render thread
+	std::unique_ptr<IngestFilter> filter;			// Keep all, latest only or decimate, per msgid
+	VehiclePool* poolPt;							// Slots for vehicles not in the config, nullptr if not discovering
 
 	/* Constructor */
-	MavSocket(string host, string port, MavAircraft* mavAircraftPt = nullptr);
+	MavSocket(string host, string port, TelemetryChannel* defaultChannelPt = nullptr);
 
 	/* Functions */
-	void startSocket();
+	void enableRecording(string directory);
+	void addForward(string ipString, int port);
+	void setIngestPolicy(string message, string policy);
+	void addRoute(uint8_t sysid, uint8_t compid, TelemetryChannel* channelPt);
+	TelemetryChannel* findRoute(uint8_t sysid, uint8_t compid);
+	void setVehiclePool(VehiclePool* poolPt);
+	void trackVehicle(const mavlink_message_t* msg, double timeReceived);
+	void openSocket(boost::asio::io_service& ioService);
+	void waitForData();
+	void handleReadable(const boost::system::error_code& error);
+	void processDatagram(const uint8_t* data, size_t len, uint64_t senderKey, double timeReceived, uint64_t timeUnixUsec);
+	bool backlogged();
+	void reportStats(double currentTime);
+	void updateRates(double currentTime);
+	void writeHealthJson(FILE* file, double currentTime);
 	void closeSocket();
 
+private:
+	/* Data */
+	std::unique_ptr<udp::socket> socket;
+	std::unique_ptr<DatagramBatch> batch;
+	std::unique_ptr<TlogRecorder> recorder;
+	std::unique_ptr<DatagramForwarder> forwarder;
+	mavlink_message_t msg;
+	std::unordered_map<uint64_t, MavParser> parsers;		// Parser per sender address and port
+	std::unordered_map<uint16_t, TelemetryChannel*> routes;	// Aircraft channel per (sysid << 8) | compid, compid 0 matches any component
+	VehicleSlot* discovered[256];					// Pool slot per sysid, ingest thread only
+	bool refusedWarned[256];						// Pool full warning printed for the sysid
+	double lastSweepTime;
+
+	/* Functions */
+	void sweepVehicles(double timeReceived);
+
 };
 
 #endif /* MAVLINKRECEIVE_H_ */
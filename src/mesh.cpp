@@ -55,6 +55,23 @@ void Mesh::Draw(Shader shader) {
 	}
 }
 
+void Mesh::DrawInstanced(Shader shader, GLsizei instanceCount) {
+	// Draws many copies in one call, per instance data comes from the buffer set by setInstanceBuffer
+	glBindVertexArray(this->VAO);
+	glDrawElementsInstanced(GL_TRIANGLES,this->indices.size(),GL_UNSIGNED_INT,0,instanceCount);
+	glBindVertexArray(0);
+}
+
+void Mesh::setInstanceBuffer(GLuint instanceVBO, GLuint location) {
+	// Adds a vec4 attribute that advances once per instance
+	glBindVertexArray(this->VAO);
+	glBindBuffer(GL_ARRAY_BUFFER,instanceVBO);
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location,4,GL_FLOAT,GL_FALSE,sizeof(glm::vec4),(GLvoid*)0);
+	glVertexAttribDivisor(location,1);
+	glBindVertexArray(0);
+}
+
 void Mesh::setupMesh() {
 	// Create buffer/arrays
 	glGenVertexArrays(1,&this->VAO);
@@ -20,6 +20,18 @@ void Model::Draw(Shader shader) {
 	}
 }
 
+void Model::DrawInstanced(Shader shader, GLsizei instanceCount) {
+	for(GLuint i = 0; i < this->meshes.size(); i++) {
+		this->meshes[i].DrawInstanced(shader, instanceCount);
+	}
+}
+
+void Model::setInstanceBuffer(GLuint instanceVBO, GLuint location) {
+	for(GLuint i = 0; i < this->meshes.size(); i++) {
+		this->meshes[i].setInstanceBuffer(instanceVBO, location);
+	}
+}
+
 
 /* Functions */
 // Loads model from file using assimp, stores resulting meshes
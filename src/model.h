@@ -29,6 +29,8 @@ public:
 
 	/* Functions */
 	void Draw(Shader shader);
+	void DrawInstanced(Shader shader, GLsizei instanceCount);
+	void setInstanceBuffer(GLuint instanceVBO, GLuint location);
 
 private:
 	/* Model Data */
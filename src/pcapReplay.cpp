@@ -0,0 +1,466 @@
+/*
+ * pcapReplay.cpp
+ */
+
+#include "pcapReplay.h"
+
+// Standard Includes
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+#define PCAP_MAX_UNMATCHED_REPORT	8		// Unmatched UDP ports listed after scanning a capture
+
+
+/* Functions */
+// Network order reads, independent of the capture file's byte order
+static uint16_t readBigEndian16(const uint8_t* pt) {
+	return (pt[0] << 8) | pt[1];
+}
+
+
+/* Constructor */
+PcapReplay::PcapReplay(std::string path, std::vector<MavSocket*> mavSocketList, PlaybackClock* clockPt) : MavReplay(path, clockPt) {
+	this->mavSocketList = mavSocketList;
+	for(unsigned int i=0; i<mavSocketList.size(); i++) {
+		socketPorts.push_back(atoi(mavSocketList[i]->port.c_str()));
+	}
+}
+
+PcapReplay::~PcapReplay() {
+	stop();
+}
+
+/* Functions */
+bool PcapReplay::isCapture(std::string path) {
+	// True if the file starts with a pcap or pcapng header in either byte order
+	FILE* file = fopen(path.c_str(), "rb");
+	if(file == NULL) {
+		return false;
+	}
+	uint32_t magic = 0;
+	size_t read = fread(&magic, sizeof(magic), 1, file);
+	fclose(file);
+	if(read != 1) {
+		return false;
+	}
+	return magic == PCAPNG_SHB || magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_NSEC
+			|| magic == __builtin_bswap32(PCAP_MAGIC_USEC) || magic == __builtin_bswap32(PCAP_MAGIC_NSEC);
+}
+
+bool PcapReplay::openFile() {
+	if(!mapFile()) {
+		return false;
+	}
+
+	// File header
+	uint32_t magic = 0;
+	if(size >= 24) {
+		memcpy(&magic, data, sizeof(magic));
+	}
+	if(magic == PCAPNG_SHB) {
+		// Byte order and interfaces come from the blocks themselves
+		pcapng = true;
+		firstOffset = 0;
+	} else if(magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_NSEC
+			|| magic == __builtin_bswap32(PCAP_MAGIC_USEC) || magic == __builtin_bswap32(PCAP_MAGIC_NSEC)) {
+		swapped = (magic == __builtin_bswap32(PCAP_MAGIC_USEC) || magic == __builtin_bswap32(PCAP_MAGIC_NSEC));
+		PcapInterface interface;
+		interface.linkType = read32(data + 20);
+		interface.exponent = (magic == PCAP_MAGIC_NSEC || magic == __builtin_bswap32(PCAP_MAGIC_NSEC)) ? 9 : 6;
+		interfaces.push_back(interface);
+		firstOffset = 24;
+	} else {
+		printf("ERROR: %s is not a pcap or pcapng capture.\n", path.c_str());
+		return false;
+	}
+
+	// Scan for the matching datagrams, the duration and the seek points
+	std::vector<uint64_t> socketDatagrams(mavSocketList.size(), 0);
+	std::unordered_map<uint16_t, uint64_t> unmatchedPorts;
+	uint64_t lastTimeUsec = 0;
+	size_t at = firstOffset;
+	size_t next;
+	PcapPacket packet;
+	ReplayRecord record;
+	while(at < size && readPacket(at, &next, &packet)) {
+		if(packet.data != nullptr) {
+			uint16_t unmatchedPort = 0;
+			if(decodeUdp(packet, &record, &unmatchedPort)) {
+				if(matchedDatagrams == 0) {
+					firstTimeUsec = record.timeUsec;
+				}
+				lastTimeUsec = std::max(lastTimeUsec, record.timeUsec);
+				if(indexRecord(lastTimeUsec, at) && pcapng) {
+					seekStates.push_back({swapped, interfaces});
+				}
+				matchedDatagrams++;
+				for(unsigned int i=0; i<mavSocketList.size(); i++) {
+					if(mavSocketList[i] == record.socketPt) {
+						socketDatagrams[i]++;
+					}
+				}
+			} else {
+				skippedPackets++;
+				if(unmatchedPort != 0) {
+					unmatchedPorts[unmatchedPort]++;
+				}
+			}
+		}
+		at = next;
+		releaseBefore(at);
+	}
+	if(at < size) {
+		printf("WARNING: %s ends with a truncated or corrupt record at byte %lu, replaying up to it.\n", path.c_str(), (unsigned long)at);
+	}
+	releaseAll();
+
+	// Summary
+	for(unsigned int i=0; i<mavSocketList.size(); i++) {
+		printf("Capture %s: %lu datagrams for port %s\n", path.c_str(), (unsigned long)socketDatagrams[i], mavSocketList[i]->port.c_str());
+	}
+	int reported = 0;
+	std::unordered_map<uint16_t, uint64_t>::iterator it;
+	for(it = unmatchedPorts.begin(); it != unmatchedPorts.end() && reported < PCAP_MAX_UNMATCHED_REPORT; it++, reported++) {
+		printf("Capture %s: %lu UDP datagrams for port %i without a link, skipped\n", path.c_str(), (unsigned long)it->second, it->first);
+	}
+	if(matchedDatagrams == 0) {
+		printf("ERROR: %s has no UDP datagrams for the configured link ports.\n", path.c_str());
+		return false;
+	}
+	duration = (lastTimeUsec - firstTimeUsec)/1e6;
+	printf("Replaying %s: %.1f s of telemetry, %lu datagrams, %lu other packets\n", path.c_str(), duration,
+			(unsigned long)matchedDatagrams, (unsigned long)skippedPackets);
+
+	// Replay from the first record, pcapng sections declare their interfaces again
+	offset = firstOffset;
+	if(pcapng) {
+		interfaces.clear();
+	}
+	return true;
+}
+
+bool PcapReplay::peekRecord(ReplayRecord* record) {
+	// Skip records until the next datagram for a link
+	PcapPacket packet;
+	uint16_t unmatchedPort;
+	while(offset < size && readPacket(offset, &nextOffset, &packet)) {
+		if(packet.data != nullptr && decodeUdp(packet, record, &unmatchedPort)) {
+			return true;
+		}
+		offset = nextOffset;
+	}
+	return false;
+}
+
+void PcapReplay::consumeRecord() {
+	offset = nextOffset;
+	releaseBefore(offset);
+}
+
+bool PcapReplay::backlogged() {
+	// Any aircraft fed by the capture
+	for(unsigned int i=0; i<mavSocketList.size(); i++) {
+		if(mavSocketList[i]->backlogged()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void PcapReplay::seekToPoint(size_t point) {
+	// pcapng also needs the byte order and interfaces of the section the point is in
+	offset = seekIndex[point].offset;
+	if(pcapng) {
+		swapped = seekStates[point].swapped;
+		interfaces = seekStates[point].interfaces;
+	}
+}
+
+uint16_t PcapReplay::read16(const uint8_t* pt) {
+	// File byte order
+	uint16_t value;
+	memcpy(&value, pt, sizeof(value));
+	return swapped ? __builtin_bswap16(value) : value;
+}
+
+uint32_t PcapReplay::read32(const uint8_t* pt) {
+	// File byte order
+	uint32_t value;
+	memcpy(&value, pt, sizeof(value));
+	return swapped ? __builtin_bswap32(value) : value;
+}
+
+bool PcapReplay::readPacket(size_t at, size_t* next, PcapPacket* packet) {
+	// Reads the record at an offset, false if it runs past the end of the file
+	if(pcapng) {
+		return readBlock(at, next, packet);
+	}
+	if(at + 16 > size) {
+		return false;
+	}
+	uint32_t capturedLength = read32(data + at + 8);
+	if(at + 16 + capturedLength > size) {
+		return false;
+	}
+	uint64_t unitsPerSecond = (interfaces[0].exponent == 9) ? 1000000000ULL : 1000000ULL;
+	packet->timeUsec = ticksToUsec(read32(data + at)*unitsPerSecond + read32(data + at + 4), interfaces[0]);
+	packet->data = data + at + 16;
+	packet->capturedLength = capturedLength;
+	packet->linkType = interfaces[0].linkType;
+	*next = at + 16 + capturedLength;
+	return true;
+}
+
+bool PcapReplay::readBlock(size_t at, size_t* next, PcapPacket* packet) {
+	// Reads one pcapng block, only enhanced packet blocks carry packets
+	if(at + 12 > size) {
+		return false;
+	}
+	uint32_t type;
+	memcpy(&type, data + at, sizeof(type));
+	if(type == PCAPNG_SHB) {
+		// New section, with its own byte order and interfaces
+		uint32_t byteOrder;
+		memcpy(&byteOrder, data + at + 8, sizeof(byteOrder));
+		if(byteOrder == PCAPNG_BYTE_ORDER) {
+			swapped = false;
+		} else if(byteOrder == __builtin_bswap32(PCAPNG_BYTE_ORDER)) {
+			swapped = true;
+		} else {
+			return false;
+		}
+		interfaces.clear();
+	} else {
+		type = read32(data + at);
+	}
+	uint32_t length = read32(data + at + 4);
+	if(length < 12 || (length & 3) != 0 || at + length > size) {
+		return false;
+	}
+	const uint8_t* body = data + at + 8;
+	size_t bodyLength = length - 12;
+	packet->data = nullptr;
+	*next = at + length;
+
+	if(type == PCAPNG_IDB) {
+		readInterface(body, bodyLength);
+	} else if(type == PCAPNG_EPB) {
+		if(bodyLength < 20) {
+			return false;
+		}
+		uint32_t interfaceId = read32(body);
+		uint32_t capturedLength = read32(body + 12);
+		if(20 + (size_t)capturedLength > bodyLength) {
+			return false;
+		}
+		if(interfaceId < interfaces.size()) {
+			uint64_t ticks = ((uint64_t)read32(body + 4) << 32) | read32(body + 8);
+			packet->timeUsec = ticksToUsec(ticks, interfaces[interfaceId]);
+			packet->data = body + 20;
+			packet->capturedLength = capturedLength;
+			packet->linkType = interfaces[interfaceId].linkType;
+		}
+	}
+	return true;
+}
+
+void PcapReplay::readInterface(const uint8_t* body, size_t length) {
+	// Link type and timestamp resolution (if_tsresol) of a pcapng interface
+	if(length < 8) {
+		return;
+	}
+	PcapInterface interface;
+	interface.linkType = read16(body);
+	size_t at = 8;
+	while(at + 4 <= length) {
+		uint16_t code = read16(body + at);
+		uint16_t optionLength = read16(body + at + 2);
+		if(code == 0 || at + 4 + optionLength > length) {
+			break;
+		}
+		if(code == 9 && optionLength >= 1) {
+			interface.binaryResolution = (body[at + 4] & 0x80) != 0;
+			interface.exponent = body[at + 4] & 0x7F;
+		}
+		at += 4 + ((optionLength + 3) & ~3);
+	}
+	interfaces.push_back(interface);
+}
+
+uint64_t PcapReplay::ticksToUsec(uint64_t ticks, const PcapInterface& interface) {
+	// Capture timestamp units to microseconds
+	if(interface.binaryResolution) {
+		return (uint64_t)(ticks * 1e6L / ldexpl(1.0L, interface.exponent));
+	}
+	for(int i=interface.exponent; i > 6; i--) {
+		ticks /= 10;
+	}
+	for(int i=interface.exponent; i < 6; i++) {
+		ticks *= 10;
+	}
+	return ticks;
+}
+
+bool PcapReplay::decodeUdp(const PcapPacket& packet, ReplayRecord* record, uint16_t* unmatchedPort) {
+	// Strips the link, IP and UDP headers, false unless the packet is a whole datagram for a link
+	const uint8_t* pt = packet.data;
+	size_t length = packet.capturedLength;
+	uint16_t etherType = 0;
+	switch(packet.linkType) {
+		case PCAP_LINK_ETHERNET: {
+			if(length < 14) {
+				return false;
+			}
+			etherType = readBigEndian16(pt + 12);
+			pt += 14;
+			length -= 14;
+			while(etherType == 0x8100 || etherType == 0x88A8) {
+				// VLAN tags
+				if(length < 4) {
+					return false;
+				}
+				etherType = readBigEndian16(pt + 2);
+				pt += 4;
+				length -= 4;
+			}
+			break;
+		}
+		case PCAP_LINK_NULL:
+		case PCAP_LINK_LOOP: {
+			if(length < 4) {
+				return false;
+			}
+			pt += 4;
+			length -= 4;
+			break;
+		}
+		case PCAP_LINK_SLL: {
+			if(length < 16) {
+				return false;
+			}
+			etherType = readBigEndian16(pt + 14);
+			pt += 16;
+			length -= 16;
+			break;
+		}
+		case PCAP_LINK_SLL2: {
+			if(length < 20) {
+				return false;
+			}
+			etherType = readBigEndian16(pt);
+			pt += 20;
+			length -= 20;
+			break;
+		}
+		case PCAP_LINK_RAW:
+		case PCAP_LINK_IPV4:
+		case PCAP_LINK_IPV6: {
+			break;
+		}
+		default: {
+			return false;
+		}
+	}
+
+	// IP version from the link layer, or the header itself
+	if(length < 1) {
+		return false;
+	}
+	int version = (etherType == 0x0800) ? 4 : (etherType == 0x86DD) ? 6 : (etherType == 0) ? (pt[0] >> 4) : 0;
+	uint32_t senderAddress;
+	if(version == 4) {
+		size_t headerLength = (pt[0] & 0x0F)*4;
+		if(length < 20 || headerLength < 20 || length < headerLength || pt[9] != 17) {
+			return false;
+		}
+		if(readBigEndian16(pt + 6) & 0x3FFF) {
+			// Fragments, MAVLink datagrams fit one packet
+			return false;
+		}
+		size_t totalLength = readBigEndian16(pt + 2);
+		if(totalLength < headerLength) {
+			// Corrupt, or 0 from a capture with segmentation offload
+			return false;
+		}
+		if(totalLength < length) {
+			// Link layer padding
+			length = totalLength;
+		}
+		memcpy(&senderAddress, pt + 12, sizeof(senderAddress));
+		pt += headerLength;
+		length -= headerLength;
+	} else if(version == 6) {
+		if(length < 40 || pt[6] != 17) {
+			return false;
+		}
+		size_t totalLength = 40 + readBigEndian16(pt + 4);
+		if(totalLength < length) {
+			length = totalLength;
+		}
+		// Fold the address into the 32 bits the parser key has for it
+		uint32_t words[4];
+		memcpy(words, pt + 8, sizeof(words));
+		senderAddress = words[0] ^ words[1] ^ words[2] ^ words[3];
+		pt += 40;
+		length -= 40;
+	} else {
+		return false;
+	}
+
+	// UDP
+	if(length < 8) {
+		return false;
+	}
+	uint16_t sourcePort = readBigEndian16(pt);
+	uint16_t destinationPort = readBigEndian16(pt + 2);
+	size_t datagramLength = readBigEndian16(pt + 4);
+	if(datagramLength < 8 || datagramLength > length) {
+		// Cut short by the capture snap length
+		return false;
+	}
+	uint16_t linkPort = matchSourcePort ? sourcePort : destinationPort;
+	MavSocket* socketPt = findSocket(linkPort);
+	if(socketPt == nullptr) {
+		*unmatchedPort = linkPort;
+		return false;
+	}
+	if(fromGroundStation(pt + 8, datagramLength - 8)) {
+		return false;
+	}
+	uint16_t sourcePortNetwork;
+	memcpy(&sourcePortNetwork, pt, sizeof(sourcePortNetwork));
+
+	record->timeUsec = packet.timeUsec;
+	record->data = pt + 8;
+	record->length = datagramLength - 8;
+	record->socketPt = socketPt;
+	record->senderKey = ((uint64_t)senderAddress << 16) | sourcePortNetwork;
+	return true;
+}
+
+bool PcapReplay::fromGroundStation(const uint8_t* frame, size_t length) {
+	// Commands and parameter traffic to the vehicle would otherwise be decoded, counted and discovered as
+	// telemetry. A datagram holds frames from one sender, so the first frame's ids decide.
+	uint8_t sysid, compid;
+	if(length >= 10 && frame[0] == MAVLINK_STX) {
+		sysid = frame[5];
+		compid = frame[6];
+	} else if(length >= 6 && frame[0] == MAVLINK_STX_MAVLINK1) {
+		sysid = frame[3];
+		compid = frame[4];
+	} else {
+		return false;
+	}
+	return sysid == PCAP_GCS_SYSID || compid == PCAP_GCS_COMPID;
+}
+
+MavSocket* PcapReplay::findSocket(uint16_t port) {
+	for(unsigned int i=0; i<socketPorts.size(); i++) {
+		if(socketPorts[i] == port) {
+			return mavSocketList[i];
+		}
+	}
+	return nullptr;
+}
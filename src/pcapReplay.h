@@ -0,0 +1,115 @@
+/*
+ * pcapReplay.h
+ */
+
+#ifndef PCAPREPLAY_H_
+#define PCAPREPLAY_H_
+
+// Standard Includes
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+// Project Includes
+#include "mavReplay.h"
+
+// Capture File Formats
+#define PCAP_MAGIC_USEC		0xA1B2C3D4
+#define PCAP_MAGIC_NSEC		0xA1B23C4D
+#define PCAPNG_SHB			0x0A0D0D0A		// Section header block
+#define PCAPNG_IDB			0x00000001		// Interface description block
+#define PCAPNG_EPB			0x00000006		// Enhanced packet block
+#define PCAPNG_BYTE_ORDER	0x1A2B3C4D
+
+// Ground station senders, whose frames aren't replayed into the vehicle links
+#define PCAP_GCS_SYSID		255
+#define PCAP_GCS_COMPID		190				// MAV_COMP_ID_MISSIONPLANNER
+
+// Link Types
+#define PCAP_LINK_NULL		0				// BSD loopback, host order address family
+#define PCAP_LINK_ETHERNET	1
+#define PCAP_LINK_RAW		101				// Bare IPv4 or IPv6
+#define PCAP_LINK_LOOP		108				// OpenBSD loopback, network order address family
+#define PCAP_LINK_SLL		113				// Linux "any" device
+#define PCAP_LINK_IPV4		228
+#define PCAP_LINK_IPV6		229
+#define PCAP_LINK_SLL2		276
+
+
+/* Structures */
+// Capture interface (pcapng can hold several with their own link type and clock resolution)
+struct PcapInterface {
+	uint32_t	linkType;
+	bool		binaryResolution = false;	// Timestamp units are 2^-exponent rather than 10^-exponent seconds
+	uint8_t		exponent = 6;
+};
+
+// One captured packet, before the link layer is removed. data is nullptr for records that aren't packets.
+struct PcapPacket {
+	uint64_t		timeUsec;
+	const uint8_t*	data;
+	size_t			capturedLength;
+	uint32_t		linkType;
+};
+
+// Section state a pcapng seek point needs, as interfaces are only described at the start of a section
+struct PcapSeekState {
+	bool						swapped;
+	std::vector<PcapInterface>	interfaces;
+};
+
+/* Classes */
+// Replays UDP datagrams from a tcpdump/Wireshark capture (pcap or pcapng) through the links in the
+// config. Each flow is matched to the MavSocket whose port is the datagram's destination port, or its
+// source port for captures taken beside the vehicle (matchSourcePort). Frames sent by a ground station
+// are skipped either way. The sender address and port select the parser, as they do for live
+// datagrams, and the capture timestamps pace the replay.
+class PcapReplay : public MavReplay {
+public:
+	/* Data */
+	uint64_t matchedDatagrams = 0;
+	uint64_t skippedPackets = 0;			// Not UDP, fragmented, truncated, from a ground station or for a port without a link
+	bool matchSourcePort = false;			// Link ports are the vehicles' ports, set before openFile
+
+	/* Constructor */
+	PcapReplay(std::string path, std::vector<MavSocket*> mavSocketList, PlaybackClock* clockPt);
+	~PcapReplay();
+
+	/* Functions */
+	static bool isCapture(std::string path);
+	bool openFile();
+
+protected:
+	/* Functions */
+	bool peekRecord(ReplayRecord* record);
+	void consumeRecord();
+	bool backlogged();
+	void seekToPoint(size_t point);
+
+private:
+	/* Data */
+	std::vector<MavSocket*> mavSocketList;
+	std::vector<uint16_t> socketPorts;
+	bool pcapng = false;
+	bool swapped = false;					// File byte order differs from this machine's
+	std::vector<PcapInterface> interfaces;
+	size_t firstOffset = 0;					// First record or block after the file header
+	size_t offset = 0;
+	size_t nextOffset = 0;					// Offset after the record at offset once peeked
+	std::vector<PcapSeekState> seekStates;	// pcapng only, one per seek point
+
+	/* Functions */
+	uint16_t read16(const uint8_t* pt);
+	uint32_t read32(const uint8_t* pt);
+	bool readPacket(size_t at, size_t* next, PcapPacket* packet);
+	bool readBlock(size_t at, size_t* next, PcapPacket* packet);
+	uint64_t ticksToUsec(uint64_t ticks, const PcapInterface& interface);
+	void readInterface(const uint8_t* body, size_t length);
+	bool decodeUdp(const PcapPacket& packet, ReplayRecord* record, uint16_t* unmatchedPort);
+	MavSocket* findSocket(uint16_t port);
+	bool fromGroundStation(const uint8_t* frame, size_t length);
+};
+
+
+#endif /* PCAPREPLAY_H_ */
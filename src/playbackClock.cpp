@@ -0,0 +1,125 @@
+/*
+ * playbackClock.cpp
+ */
+
+#include "playbackClock.h"
+
+// Standard Includes
+#include <cstdio>
+#include <algorithm>
+
+
+/* Global Clock */
+PlaybackClock playbackClock;
+
+/* Constructor */
+PlaybackClock::PlaybackClock() : catchingUp(false), live(true), seeks(0) {
+	wallStart = std::chrono::steady_clock::now();
+}
+
+/* Functions */
+double PlaybackClock::now() {
+	// Current clock time (s)
+	if(live) {
+		return wallTime();
+	}
+	std::lock_guard<std::mutex> lock(clockLock);
+	return timeAt(wallTime());
+}
+
+double PlaybackClock::wallTime() {
+	// Seconds since the clock was created
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+}
+
+int64_t PlaybackClock::epochNs() {
+	// Steady clock reading at wall time zero, comparable between processes on the same machine
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(wallStart.time_since_epoch()).count();
+}
+
+void PlaybackClock::startReplay(double speed) {
+	// Switch to replay time, starting at zero
+	std::lock_guard<std::mutex> lock(clockLock);
+	this->speed = speed;
+	anchorWall = wallTime();
+	anchorTime = 0;
+	live = false;
+}
+
+bool PlaybackClock::isLive() {
+	return live;
+}
+
+bool PlaybackClock::isPaused() {
+	std::lock_guard<std::mutex> lock(clockLock);
+	return paused;
+}
+
+bool PlaybackClock::asFastAsPossible() {
+	std::lock_guard<std::mutex> lock(clockLock);
+	return speed == PLAYBACK_AS_FAST_AS_POSSIBLE;
+}
+
+double PlaybackClock::getSpeed() {
+	std::lock_guard<std::mutex> lock(clockLock);
+	return speed;
+}
+
+void PlaybackClock::setSpeed(double speed) {
+	// Changes the replay rate without moving the current time
+	if(live) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(clockLock);
+	reanchor();
+	this->speed = std::min(speed, PLAYBACK_MAX_SPEED);
+	printf("Playback speed: %.3gx\n",this->speed);
+}
+
+void PlaybackClock::togglePause() {
+	if(live) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(clockLock);
+	reanchor();
+	paused = !paused;
+	printf("Playback %s at %.1f s\n",paused ? "paused" : "resumed",anchorTime);
+}
+
+void PlaybackClock::seek(double offset) {
+	// Moves the replay time by offset (s), never before the start of the replay
+	if(live) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(clockLock);
+	reanchor();
+	anchorTime = std::max(0.0, anchorTime + offset);
+	seeks++;
+	printf("Playback seek to %.1f s\n",anchorTime);
+}
+
+void PlaybackClock::advanceTo(double time) {
+	// Data driven time for as fast as possible replays
+	std::lock_guard<std::mutex> lock(clockLock);
+	anchorWall = wallTime();
+	anchorTime = std::max(anchorTime, time);
+}
+
+uint32_t PlaybackClock::seekCount() {
+	return seeks;
+}
+
+double PlaybackClock::timeAt(double wall) {
+	// Replay time at a wall time, clockLock must be held
+	if(paused || speed == PLAYBACK_AS_FAST_AS_POSSIBLE) {
+		return anchorTime;
+	}
+	return anchorTime + (wall - anchorWall)*speed;
+}
+
+void PlaybackClock::reanchor() {
+	// Fold the elapsed time into the anchor before changing the rate, clockLock must be held
+	double wall = wallTime();
+	anchorTime = timeAt(wall);
+	anchorWall = wall;
+}
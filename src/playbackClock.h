@@ -0,0 +1,65 @@
+/*
+ * playbackClock.h
+ */
+
+#ifndef PLAYBACKCLOCK_H_
+#define PLAYBACKCLOCK_H_
+
+// Standard Includes
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Playback Speeds
+#define PLAYBACK_AS_FAST_AS_POSSIBLE	0.0
+#define PLAYBACK_MAX_SPEED				256.0
+
+
+/* Classes */
+// Time base shared by the telemetry sources and the aircraft. Live links run on the wall clock,
+// replays run on a clock that can be paused, sped up and moved.
+class PlaybackClock {
+public:
+	/* Data */
+	std::atomic<bool> catchingUp;			// Set while a replay is emitting data older than the clock
+
+	/* Constructor */
+	PlaybackClock();
+
+	/* Functions */
+	double now();
+	double wallTime();
+	int64_t epochNs();
+	void startReplay(double speed);
+	bool isLive();
+	bool isPaused();
+	bool asFastAsPossible();
+	double getSpeed();
+	void setSpeed(double speed);
+	void togglePause();
+	void seek(double offset);
+	void advanceTo(double time);
+	uint32_t seekCount();
+
+private:
+	/* Data */
+	std::mutex clockLock;
+	std::chrono::steady_clock::time_point wallStart;
+	std::atomic<bool> live;
+	std::atomic<uint32_t> seeks;			// Seeks so far, so the replay can tell the clock moved
+	bool paused = false;
+	double speed = 1.0;
+	double anchorWall = 0;					// Wall time of the last speed/pause/seek change (s)
+	double anchorTime = 0;					// Clock time at anchorWall (s)
+
+	/* Functions */
+	double timeAt(double wall);
+	void reanchor();
+};
+
+/* Global Clock */
+extern PlaybackClock playbackClock;
+
+
+#endif /* PLAYBACKCLOCK_H_ */
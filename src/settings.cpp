@@ -49,7 +49,10 @@ void Settings::parseSetting(std::string line) {
 	std::vector<std::string> lineSplit;
 	boost::split(lineSplit, line, boost::is_any_of("\t "), boost::token_compress_on);
 	// Check setting type
-	if (lineSplit.size() == 3) {
+	if (lineSplit.size() == 3 && lineSplit[0]=="history") {
+		// History retention
+		parseHistorySettings(line, lineSplit);
+	} else if (lineSplit.size() == 3) {
 		if (lineSplit[1]=="int") {
 			// Look through ints
 			parseIntSettings(line, lineSplit);
@@ -59,6 +62,21 @@ void Settings::parseSetting(std::string line) {
 		} else {
 			printf("ERROR: Unknown Setting! %s: Line %i\n",lineSplit[0].c_str(),lineNum);
 		}
+	} else if (lineSplit.size() == 4 && lineSplit[0]=="forward") {
+		// Forward a link to another UDP endpoint
+		parseForwardSettings(line, lineSplit);
+	} else if (lineSplit.size() == 4 && lineSplit[0]=="ingest") {
+		// Decimate or coalesce a message type on a link
+		parseIngestSettings(line, lineSplit);
+	} else if (lineSplit.size() == 4 && lineSplit[0]=="publish") {
+		// Publish the interpolated aircraft state
+		parsePublishSettings(line, lineSplit);
+	} else if (lineSplit.size() == 4 && lineSplit[0]=="traffic") {
+		// ADS-B traffic feed
+		parseTrafficSettings(line, lineSplit);
+	} else if (lineSplit.size() == 5 && lineSplit[0]=="discover") {
+		// Pool of aircraft for vehicles not listed
+		parseDiscoverSettings(line, lineSplit);
 	} else if (lineSplit.size() == 5) {
 		if (lineSplit[0]=="origin") {
 			parseOriginSettings(line, lineSplit);
@@ -67,6 +85,9 @@ void Settings::parseSetting(std::string line) {
 			// Look through aircraft
 			parseAircraftSettings(line, lineSplit);
 		}
+	} else if (lineSplit.size() == 6 && lineSplit[0]=="aircraft") {
+		// Aircraft with a sysid
+		parseAircraftSettings(line, lineSplit);
 	} else if (lineSplit.size() > 10) {
 		if (lineSplit[0] == "volume") {
 			// Look through volume definition
@@ -118,11 +139,104 @@ void Settings::parseAircraftSettings(std::string line, std::vector<std::string>
 	std::string filepath = lineSplit[2];
 	std::string ipString = lineSplit[3];
 	std::string	port = lineSplit[4];
+	int sysid = 0;
+	if (lineSplit.size() > 5) {
+		sysid = stoi(lineSplit[5]);
+	}
 
-	aircraftConnection aircraftCon = {name,filepath,ipString,port};
+	aircraftConnection aircraftCon = {name,filepath,ipString,port,sysid};
 	aircraftConList.push_back(aircraftCon);
 }
 
+void Settings::parseDiscoverSettings(std::string line, std::vector<std::string> lineSplit) {
+	// Parses discovery settings into the class
+	std::string ipString = lineSplit[1];
+	std::string port = lineSplit[2];
+	std::string filepath = lineSplit[3];
+	int slots = stoi(lineSplit[4]);
+
+	// A link has one pool, a second would replace the first and leave its slots unused
+	for (unsigned int i=0; i<discoverList.size(); i++) {
+		if (discoverList[i].ipString == ipString && discoverList[i].port == port) {
+			printf("WARNING: %s:%s already has a discover line, ignoring: Line %i\n",ipString.c_str(),port.c_str(),lineNum);
+			return;
+		}
+	}
+
+	discoverDef discover = {ipString,port,filepath,slots};
+	discoverList.push_back(discover);
+}
+
+void Settings::parseForwardSettings(std::string line, std::vector<std::string> lineSplit) {
+	// Parses forward settings into the class
+	std::string linkPort = lineSplit[1];
+	std::string ipString = lineSplit[2];
+	int port = stoi(lineSplit[3]);
+
+	forwardDef forward = {linkPort,ipString,port};
+	forwardList.push_back(forward);
+}
+
+void Settings::parseIngestSettings(std::string line, std::vector<std::string> lineSplit) {
+	// Parses ingest policy settings into the class
+	std::string linkPort = lineSplit[1];
+	std::string message = lineSplit[2];
+	std::string policy = lineSplit[3];
+
+	ingestDef ingest = {linkPort,message,policy};
+	ingestList.push_back(ingest);
+}
+
+void Settings::parsePublishSettings(std::string line, std::vector<std::string> lineSplit) {
+	// Parses state publisher settings into the class
+	std::string type = lineSplit[1];
+	std::string address = lineSplit[2];
+	double rate = atof(lineSplit[3].c_str());
+
+	publishDef publish = {type,address,rate};
+	publishList.push_back(publish);
+}
+
+void Settings::parseTrafficSettings(std::string line, std::vector<std::string> lineSplit) {
+	// Parses traffic settings into the class
+	if (lineSplit[1] != "tcp" && lineSplit[1] != "file") {
+		printf("ERROR: Traffic source must be tcp or file: Line %i\n",lineNum);
+		return;
+	}
+	bool isFile = (lineSplit[1] == "file");
+	std::string source = lineSplit[2];
+	std::string filepath = lineSplit[3];
+
+	traffic = {source,isFile,filepath};
+	trafficSet = true;
+}
+
+void Settings::parseHistorySettings(std::string line, std::vector<std::string> lineSplit) {
+	// Parses history retention settings into the class, a count of samples or a time span ending in s
+	if (lineSplit[1] == "spill") {
+		historySpill = lineSplit[2];
+		return;
+	}
+	historyDef history = {0,0};
+	if (lineSplit[2].back() == 's') {
+		history.seconds = atof(lineSplit[2].c_str());
+	} else {
+		history.length = stoul(lineSplit[2]);
+		if (history.length == 1) {
+			// Interpolation needs a sample either side of the time shown
+			printf("WARNING: History keeps at least 2 samples, using 2: Line %i\n",lineNum);
+			history.length = 2;
+		}
+	}
+	if (lineSplit[1] == "position") {
+		positionHistory = history;
+	} else if (lineSplit[1] == "attitude") {
+		attitudeHistory = history;
+	} else {
+		printf("ERROR: History must be position, attitude or spill: Line %i\n",lineNum);
+	}
+}
+
 void Settings::parseVolumeSettings(std::string line, std::vector<std::string> lineSplit) {
 	// Parses volume settings into the class
 	std::string name = lineSplit[1];
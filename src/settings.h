@@ -30,6 +30,43 @@ struct aircraftConnection {
 	std::string filepath;
 	std::string ipString;
 	std::string	port;
+	int			sysid;		// MAVLink system id on a shared port, 0 accepts any system
+};
+
+struct discoverDef {
+	std::string	ipString;
+	std::string	port;
+	std::string	filepath;	// Model shared by every slot
+	int			slots;		// Vehicles shown at once
+};
+
+struct forwardDef {
+	std::string	linkPort;	// Port of the aircraft link whose datagrams are forwarded
+	std::string	ipString;
+	int			port;
+};
+
+struct ingestDef {
+	std::string	linkPort;	// Port of the aircraft link the policy applies to
+	std::string	message;	// MAVLink message name or msgid
+	std::string	policy;		// all, latest or a rate in Hz
+};
+
+struct publishDef {
+	std::string	type;		// udp or unix
+	std::string	address;	// host:port, or a socket path
+	double		rate;		// Snapshots per second
+};
+
+struct trafficDef {
+	std::string	source;		// host:port of an SBS-1 feed, or a recorded file
+	bool		isFile;
+	std::string	filepath;	// Model drawn for each target
+};
+
+struct historyDef {
+	size_t		length;		// Samples kept, 0 for no limit
+	double		seconds;	// Span kept (s), 0 for no limit
 };
 
 struct volumeDef {
@@ -67,6 +104,27 @@ public:
 	// Aircraft
 	std::vector<aircraftConnection> aircraftConList;
 
+	// Discovery
+	std::vector<discoverDef> discoverList;
+
+	// Forwarding
+	std::vector<forwardDef> forwardList;
+
+	// Ingest Policies
+	std::vector<ingestDef> ingestList;
+
+	// State Publishers
+	std::vector<publishDef> publishList;
+
+	// Traffic
+	trafficDef	traffic;
+	bool		trafficSet = false;
+
+	// History Retention
+	historyDef	positionHistory = {0,0};
+	historyDef	attitudeHistory = {0,0};
+	std::string	historySpill;			// Directory to keep the history files in, empty for temporary files
+
 	// Volumes
 	std::vector<volumeDef> volumeList;
 
@@ -85,6 +143,12 @@ public:
 	void parseBoolSettings(std::string line, std::vector<std::string> lineSplit);
 	void parseOriginSettings(std::string line, std::vector<std::string> lineSplit);
 	void parseAircraftSettings(std::string line, std::vector<std::string> lineSplit);
+	void parseDiscoverSettings(std::string line, std::vector<std::string> lineSplit);
+	void parseForwardSettings(std::string line, std::vector<std::string> lineSplit);
+	void parseIngestSettings(std::string line, std::vector<std::string> lineSplit);
+	void parsePublishSettings(std::string line, std::vector<std::string> lineSplit);
+	void parseTrafficSettings(std::string line, std::vector<std::string> lineSplit);
+	void parseHistorySettings(std::string line, std::vector<std::string> lineSplit);
 	void parseVolumeSettings(std::string line, std::vector<std::string> lineSplit);
 	void checkMissingSettings();
 
@@ -0,0 +1,163 @@
+/*
+ * statePublisher.cpp
+ */
+
+#include "statePublisher.h"
+
+// Standard Includes
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <algorithm>
+
+// Socket Includes
+#include <netdb.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static_assert(sizeof(StateSnapshotHeader) == 48, "StateSnapshotHeader layout changed");
+static_assert(sizeof(StateRecord) == 80, "StateRecord layout changed");
+
+
+/* Constructor */
+StatePublisher::StatePublisher() : period(0), socketFd(-1), addressLength(0), header(nullptr), records(nullptr), capacity(0), truncatedWarned(false), nextPublish(0) {
+	memset(&address, 0, sizeof(address));
+}
+
+StatePublisher::~StatePublisher() {
+	if(socketFd >= 0) {
+		close(socketFd);
+	}
+}
+
+/* Functions */
+bool StatePublisher::open(std::string type, std::string address, double rate, glm::dvec3 origin, size_t numAircraft) {
+	// Resolves the destination and allocates the snapshot for numAircraft records. type is udp (address
+	// host:port) or unix (address a path).
+	if(rate <= 0) {
+		printf("WARNING: Publish rate must be positive, ignoring %s %s.\n",type.c_str(),address.c_str());
+		return false;
+	}
+	period = 1.0/rate;
+	name = type + ":" + address;
+	if(type == "udp") {
+		std::string host = address.substr(0, address.find_last_of(':'));
+		std::string port = address.substr(address.find_last_of(':') + 1);
+		struct addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_DGRAM;
+		struct addrinfo* result = NULL;
+		if(address.find(':') == std::string::npos || getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) {
+			printf("WARNING: Invalid publish address %s.\n",address.c_str());
+			return false;
+		}
+		memcpy(&this->address, result->ai_addr, result->ai_addrlen);
+		addressLength = result->ai_addrlen;
+		socketFd = socket(result->ai_family, SOCK_DGRAM, 0);
+		freeaddrinfo(result);
+	} else if(type == "unix") {
+		struct sockaddr_un* unixAddress = (struct sockaddr_un*)&this->address;
+		if(address.size() >= sizeof(unixAddress->sun_path)) {
+			printf("WARNING: Publish socket path too long, %s.\n",address.c_str());
+			return false;
+		}
+		unixAddress->sun_family = AF_UNIX;
+		strcpy(unixAddress->sun_path, address.c_str());
+		addressLength = sizeof(struct sockaddr_un);
+		socketFd = socket(AF_UNIX, SOCK_DGRAM, 0);
+	} else {
+		printf("WARNING: Publish type must be udp or unix, ignoring %s.\n",type.c_str());
+		return false;
+	}
+	if(socketFd < 0) {
+		perror("Publish socket");
+		return false;
+	}
+
+	// Snapshot storage, the header fields that never change are filled once
+	capacity = std::min((int)numAircraft, STATE_PUBLISH_MAX_AIRCRAFT);
+	size_t length = sizeof(StateSnapshotHeader) + capacity*sizeof(StateRecord);
+	buffer.assign((length + sizeof(uint64_t) - 1)/sizeof(uint64_t), 0);
+	header = reinterpret_cast<StateSnapshotHeader*>(buffer.data());
+	records = reinterpret_cast<StateRecord*>(header + 1);
+	header->magic = STATE_PUBLISH_MAGIC;
+	header->version = STATE_PUBLISH_VERSION;
+	header->recordSize = sizeof(StateRecord);
+	header->origin[0] = origin[0];
+	header->origin[1] = origin[1];
+	header->origin[2] = origin[2]*1000.0;
+	return true;
+}
+
+void StatePublisher::update(double frameTime, double currentTime, std::vector<MavAircraft>& aircraftList) {
+	// Publishes if a snapshot is due. frameTime is the steady frame clock, so replay speed doesn't change the rate.
+	if(socketFd < 0 || frameTime < nextPublish) {
+		return;
+	}
+	publish(currentTime, aircraftList);
+
+	// Keep to the schedule, but don't send a burst to catch up after a stall
+	nextPublish += period;
+	if(nextPublish < frameTime) {
+		nextPublish = frameTime + period;
+	}
+}
+
+void StatePublisher::publish(double currentTime, std::vector<MavAircraft>& aircraftList) {
+	// Writes the records in place and sends the snapshot, skipping pool slots with no vehicle
+	int n = 0;
+	header->time = currentTime;
+	for(unsigned int i=0; i<aircraftList.size(); i++) {
+		MavAircraft& aircraft = aircraftList[i];
+		if(!aircraft.active) {
+			continue;
+		}
+		if(n == capacity) {
+			if(!truncatedWarned) {
+				printf("WARNING: Publisher %s holds %i aircraft, later aircraft are left out.\n",name.c_str(),capacity);
+				truncatedWarned = true;
+			}
+			break;
+		}
+		StateRecord& record = records[n++];
+		strncpy(record.name, aircraft.name.c_str(), STATE_NAME_LENGTH - 1);
+		record.name[STATE_NAME_LENGTH - 1] = '\0';
+		record.index = i;
+		record.flags = 0;
+		if(aircraft.currentPosMsgIndex > 1) {
+			record.flags |= STATE_POSITION_VALID;
+		}
+		if(aircraft.currentAttMsgIndex > 1) {
+			record.flags |= STATE_ATTITUDE_VALID;
+		}
+		record.displayTime = aircraft.displayTime;
+		for(int j=0; j<3; j++) {
+			record.position[j] = aircraft.position[j];
+			record.velocity[j] = aircraft.velocity[j];
+		}
+
+		// The drawn yaw is negated for the y up model rotation, send it as MAVLink reports it
+		record.attitude[0] = aircraft.attitude[0];
+		record.attitude[1] = aircraft.attitude[1];
+		record.attitude[2] = -aircraft.attitude[2];
+	}
+	header->numAircraft = n;
+	size_t length = sizeof(StateSnapshotHeader) + n*sizeof(StateRecord);
+	ssize_t result;
+	do {
+		result = sendto(socketFd, buffer.data(), length, MSG_DONTWAIT, (struct sockaddr*)&address, addressLength);
+	} while(result < 0 && errno == EINTR);
+	if(result < 0) {
+		// Buffer full, nobody listening on the path or the port unreachable
+		dropped.add();
+	} else {
+		sent.add();
+	}
+	header->sequence++;
+}
+
+void StatePublisher::report() {
+	// Prints totals
+	printf("Publisher %s: sent %lu snapshots, %lu dropped\n",name.c_str(),(unsigned long)sent.get(),(unsigned long)dropped.get());
+}
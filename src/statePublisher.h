@@ -0,0 +1,92 @@
+/*
+ * statePublisher.h
+ */
+
+#ifndef STATEPUBLISHER_H_
+#define STATEPUBLISHER_H_
+
+// Standard Includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Socket Includes
+#include <sys/socket.h>
+
+// Project Includes
+#include "mavAircraft.h"
+#include "linkHealth.h"
+
+#define STATE_PUBLISH_MAGIC			0x4D4C4753		// "SGLM"
+#define STATE_PUBLISH_VERSION		1				// Bump when the layout changes
+#define STATE_PUBLISH_MAX_AIRCRAFT	818				// Records that fit in one UDP datagram
+#define STATE_NAME_LENGTH			16				// Aircraft name, truncated and null terminated
+
+// Record flags
+#define STATE_POSITION_VALID		(1 << 0)
+#define STATE_ATTITUDE_VALID		(1 << 1)
+
+
+/* Structures */
+// Snapshot layout, host byte order. A header is followed by numAircraft records, all naturally aligned.
+// Pool slots without a vehicle are left out, so records are matched by index rather than position.
+struct StateSnapshotHeader {
+	uint32_t	magic;
+	uint16_t	version;
+	uint16_t	numAircraft;
+	uint32_t	sequence;							// Increments every snapshot, gaps are lost datagrams
+	uint32_t	recordSize;							// sizeof(StateRecord)
+	double		time;								// Playback clock time of the frame (s)
+	double		origin[3];							// Lat (deg), Lon (deg), alt (m) of the NEU frame
+};
+
+struct StateRecord {
+	char		name[STATE_NAME_LENGTH];
+	uint32_t	index;								// Position in the aircraft list, config aircraft then pool slots
+	uint32_t	flags;								// STATE_ _VALID flags
+	double		displayTime;						// Autopilot time being displayed (s)
+	double		position[3];						// North, east, up from the origin (m), the up axis is altitude not MAVLink down
+	float		velocity[3];						// North, east, up (m/s), vz already negated from MAVLink down
+	float		attitude[3];						// Roll, pitch, yaw (rad) as MAVLink ATTITUDE, yaw clockwise from north
+};
+
+/* Classes */
+// Sends the interpolated state of every aircraft, as drawn, to a local UDP port or Unix datagram socket
+// at a fixed rate. The snapshot is written straight into a buffer allocated when the publisher opens
+// and leaves in one non-blocking send; if the reader is slow or absent the snapshot is dropped and
+// counted, never waited on. Called from the render loop, so rates above the frame rate are capped by it.
+class StatePublisher {
+public:
+	/* Data */
+	std::string		name;							// udp:host:port or unix:path, for reporting
+	double			period;							// Time between snapshots (s)
+	RelaxedCounter	sent;
+	RelaxedCounter	dropped;
+
+	/* Constructor */
+	StatePublisher();
+	~StatePublisher();
+
+	/* Functions */
+	bool open(std::string type, std::string address, double rate, glm::dvec3 origin, size_t numAircraft);
+	void update(double frameTime, double currentTime, std::vector<MavAircraft>& aircraftList);
+	void report();
+
+private:
+	/* Data */
+	int						socketFd;
+	struct sockaddr_storage	address;
+	socklen_t				addressLength;
+	std::vector<uint64_t>	buffer;					// 8 byte aligned storage for the snapshot
+	StateSnapshotHeader*	header;
+	StateRecord*			records;
+	int						capacity;				// Records the buffer holds
+	bool					truncatedWarned;
+	double					nextPublish;
+
+	/* Functions */
+	void publish(double currentTime, std::vector<MavAircraft>& aircraftList);
+};
+
+
+#endif /* STATEPUBLISHER_H_ */
@@ -67,6 +67,24 @@ void TelemOverlay::DrawAirspeed() {
 	std::stringstream ss;
 	ss << std::setprecision(3) << mavAircraftPt->airspeed << " m/s";
 	telemFontPt->RenderText(telemTextShaderPt,ss.str(),pos[0],pos[1],1.0f,glm::vec3(0.0f, 1.0f, 0.0f),0);
+
+	// Rebuild the status text only when the vehicle state has changed
+	if(mavAircraftPt->stateVersion != statusVersion) {
+		const TelemetryState& state = mavAircraftPt->state;
+		std::stringstream st;
+		if(state.fieldsValid & TELEM_STATE_HEARTBEAT) {
+			st << ((state.baseMode & MAV_MODE_FLAG_SAFETY_ARMED) ? "ARMED" : "DISARMED") << " mode " << state.customMode << " ";
+		}
+		if(state.fieldsValid & TELEM_STATE_GPS) {
+			st << "GPS " << (int)state.gpsFixType << " " << (int)state.gpsSatellites << " sats ";
+		}
+		if(state.fieldsValid & (TELEM_STATE_SYS_STATUS | TELEM_STATE_BATTERY)) {
+			st << std::fixed << std::setprecision(1) << state.batteryVoltage << " V " << (int)state.batteryRemaining << "%";
+		}
+		statusText = st.str();
+		statusVersion = mavAircraftPt->stateVersion;
+	}
+	telemFontPt->RenderText(telemTextShaderPt,statusText,pos[0],pos[1]-20,1.0f,glm::vec3(0.0f, 1.0f, 0.0f),0);
 }
 
 glm::vec2 TelemOverlay::convertNDC2Screen() {
@@ -11,6 +11,9 @@
 // Standard Includes
 #include "iomanip"
 
+// Mavlink Includes
+#include <c_library_v2/ardupilotmega/mavlink.h>
+
 // Project Includes
 #include "camera.h"
 
@@ -47,6 +50,10 @@ public:
 	// Color
 	glm::vec3 color;
 
+	// Status Text
+	std::string statusText;
+	uint32_t statusVersion = 0;
+
 	/* Constructor */
 	TelemOverlay(MavAircraft* mavAircraftPt,Shader* telemTextShaderPt,GLFont* telemFontPt, glm::vec3 color, Settings* settings);
 
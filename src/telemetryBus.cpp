@@ -0,0 +1,191 @@
+/*
+ * telemetryBus.cpp
+ */
+
+#include "telemetryBus.h"
+
+// Standard Includes
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <new>
+
+// Shared Memory Includes
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <signal.h>
+
+// Project Includes
+#include "playbackClock.h"
+
+
+/* Constructor */
+TelemetryBus::TelemetryBus() {
+	header = nullptr;
+	mappedSize = 0;
+	owner = false;
+}
+
+TelemetryBus::~TelemetryBus() {
+	close();
+}
+
+/* Functions */
+bool TelemetryBus::create(std::string name, const std::vector<std::string>& aircraftNames, bool replace) {
+	// Creates the bus with one slot per aircraft. A bus left by an ingest that has exited is replaced;
+	// one whose ingest is still running is only replaced if asked to.
+	this->name = name;
+	int writerPid = liveWriter(name);
+	if(writerPid > 0) {
+		if(!replace) {
+			printf("ERROR: Telemetry bus %s is in use by process %i, use -f to replace it.\n", name.c_str(), writerPid);
+			return false;
+		}
+		printf("WARNING: Replacing telemetry bus %s in use by process %i.\n", name.c_str(), writerPid);
+	}
+	shm_unlink(name.c_str());
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if(fd < 0) {
+		perror("shm_open");
+		return false;
+	}
+	size_t size = sizeof(TelemetryBusHeader) + aircraftNames.size()*sizeof(BusAircraft);
+	if(ftruncate(fd, size) != 0) {
+		perror("ftruncate");
+		::close(fd);
+		shm_unlink(name.c_str());
+		return false;
+	}
+	void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(data == MAP_FAILED) {
+		perror("mmap");
+		shm_unlink(name.c_str());
+		return false;
+	}
+	header = (TelemetryBusHeader*)data;
+	mappedSize = size;
+	owner = true;
+
+	// Build the layout in place
+	header->magic.store(0, std::memory_order_relaxed);
+	header->version = TELEMETRY_BUS_VERSION;
+	header->numAircraft = aircraftNames.size();
+	header->sampleSize = sizeof(TelemetrySample);
+	header->clockEpochNs = playbackClock.epochNs();
+	header->ingestPid = getpid();
+	for(unsigned int i=0; i<aircraftNames.size(); i++) {
+		BusAircraft* slot = new (aircraft(i)) BusAircraft();
+		strncpy(slot->name, aircraftNames[i].c_str(), TELEMETRY_BUS_NAME_LENGTH - 1);
+		slot->name[TELEMETRY_BUS_NAME_LENGTH - 1] = '\0';
+	}
+
+	// Ready for viewers
+	header->magic.store(TELEMETRY_BUS_MAGIC, std::memory_order_release);
+	printf("Telemetry bus %s: %lu aircraft, %.1f MB\n",name.c_str(),(unsigned long)aircraftNames.size(),size/1e6);
+	return true;
+}
+
+int TelemetryBus::liveWriter(std::string name) {
+	// Process id of the running ingest writing an existing bus, 0 if there is no bus or its ingest has exited
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if(fd < 0) {
+		return 0;
+	}
+	struct stat info;
+	if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(TelemetryBusHeader)) {
+		::close(fd);
+		return 0;
+	}
+	void* data = mmap(NULL, sizeof(TelemetryBusHeader), PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(data == MAP_FAILED) {
+		return 0;
+	}
+	TelemetryBusHeader* existing = (TelemetryBusHeader*)data;
+	int pid = 0;
+	if(existing->magic.load(std::memory_order_acquire) == TELEMETRY_BUS_MAGIC && existing->ingestPid > 0) {
+		pid = existing->ingestPid;
+	}
+	munmap(data, sizeof(TelemetryBusHeader));
+
+	// Signal 0 only checks the process exists, EPERM means it exists under another user
+	if(pid == 0 || pid == getpid() || (kill(pid, 0) != 0 && errno != EPERM)) {
+		return 0;
+	}
+	return pid;
+}
+
+bool TelemetryBus::attach(std::string name) {
+	// Maps an existing bus read only
+	this->name = name;
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if(fd < 0) {
+		printf("ERROR: Telemetry bus %s not found, is the ingest process running?\n",name.c_str());
+		return false;
+	}
+	struct stat info;
+	if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(TelemetryBusHeader)) {
+		printf("ERROR: Telemetry bus %s is not ready.\n",name.c_str());
+		::close(fd);
+		return false;
+	}
+	void* data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(data == MAP_FAILED) {
+		perror("mmap");
+		return false;
+	}
+	header = (TelemetryBusHeader*)data;
+	mappedSize = info.st_size;
+	owner = false;
+
+	// Check layout
+	if(header->magic.load(std::memory_order_acquire) != TELEMETRY_BUS_MAGIC || header->version != TELEMETRY_BUS_VERSION
+			|| header->sampleSize != sizeof(TelemetrySample)
+			|| mappedSize < sizeof(TelemetryBusHeader) + header->numAircraft*sizeof(BusAircraft)) {
+		printf("ERROR: Telemetry bus %s has a different layout, rebuild the ingest process.\n",name.c_str());
+		close();
+		return false;
+	}
+	printf("Attached to telemetry bus %s: %u aircraft from process %i\n",name.c_str(),header->numAircraft,header->ingestPid);
+	return true;
+}
+
+BusAircraft* TelemetryBus::findAircraft(const std::string& aircraftName) {
+	// Slot with a matching name, nullptr if the ingest process doesn't have it
+	for(int i=0; i<numAircraft(); i++) {
+		if(aircraftName == aircraft(i)->name) {
+			return aircraft(i);
+		}
+	}
+	return nullptr;
+}
+
+BusAircraft* TelemetryBus::aircraft(int i) {
+	return (BusAircraft*)((char*)header + sizeof(TelemetryBusHeader)) + i;
+}
+
+int TelemetryBus::numAircraft() {
+	return (header != nullptr) ? header->numAircraft : 0;
+}
+
+double TelemetryBus::clockOffset() {
+	// Add to an ingest sample time to get this process's clock time
+	return (header->clockEpochNs - playbackClock.epochNs())/1e9;
+}
+
+void TelemetryBus::close() {
+	// Unmaps, and removes the name if this process created it
+	if(header != nullptr) {
+		if(owner) {
+			header->magic.store(0, std::memory_order_release);
+			shm_unlink(name.c_str());
+		}
+		munmap(header, mappedSize);
+		header = nullptr;
+		mappedSize = 0;
+	}
+}
@@ -0,0 +1,67 @@
+/*
+ * telemetryBus.h
+ */
+
+#ifndef TELEMETRYBUS_H_
+#define TELEMETRYBUS_H_
+
+// Standard Includes
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Project Includes
+#include "telemetryState.h"
+
+#define TELEMETRY_BUS_DEFAULT_NAME	"/openGLMap"
+#define TELEMETRY_BUS_MAGIC			0x4D415642		// "MAVB", written last once the bus is ready
+#define TELEMETRY_BUS_VERSION		3				// Bump when the layout changes
+
+
+/* Structures */
+// Start of the shared memory object, followed by numAircraft BusAircraft
+struct TelemetryBusHeader {
+	std::atomic<uint32_t>	magic;
+	uint32_t				version;
+	uint32_t				numAircraft;
+	uint32_t				sampleSize;				// sizeof(TelemetrySample), guards against mismatched builds
+	int64_t					clockEpochNs;			// Ingest PlaybackClock epoch, converts its sample times
+	int32_t					ingestPid;
+	char					pad[36];
+};
+
+/* Classes */
+// POSIX shared memory holding decoded telemetry for every aircraft. The ingest process creates it and
+// publishes into it from its sockets; any number of viewers attach read only and follow the rings
+// with their own cursors, so decoding happens once however many viewers run.
+class TelemetryBus {
+public:
+	/* Data */
+	std::string		name;
+
+	/* Constructor */
+	TelemetryBus();
+	~TelemetryBus();
+
+	/* Functions */
+	bool create(std::string name, const std::vector<std::string>& aircraftNames, bool replace = false);
+	bool attach(std::string name);
+	BusAircraft* findAircraft(const std::string& aircraftName);
+	BusAircraft* aircraft(int i);
+	int numAircraft();
+	double clockOffset();
+	void close();
+
+private:
+	/* Data */
+	TelemetryBusHeader*		header;
+	size_t					mappedSize;
+	bool					owner;					// The creator unlinks the name on close
+
+	/* Functions */
+	int liveWriter(std::string name);
+};
+
+
+#endif /* TELEMETRYBUS_H_ */
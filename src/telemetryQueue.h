@@ -0,0 +1,107 @@
+/*
+ * telemetryQueue.h
+ */
+
+#ifndef TELEMETRYQUEUE_H_
+#define TELEMETRYQUEUE_H_
+
+// Standard Includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// GLM Mathematics
+#include <glm/glm.hpp>
+
+// Size of the per aircraft sample queue (must be a power of two)
+#define TELEMETRY_QUEUE_LENGTH 1024
+
+
+/* Structures */
+enum TelemetryType : uint8_t {
+	TELEM_POSITION,
+	TELEM_ATTITUDE,
+	TELEM_CLOCK,							// Autopilot time only (SYSTEM_TIME, TIMESYNC), for clock estimation
+	TELEM_TYPE_COUNT
+};
+
+struct TelemetrySample {
+	TelemetryType	type;
+	double			timeBoot;				// Autopilot boot time of the message (s), double keeps it exact to the ms
+	double			timeReceived;			// Local time the message was received (s)
+	glm::dvec3		value;					// Position: lat (deg), lon (deg), alt (m). Attitude: roll, pitch, yaw (rad)
+	glm::dvec3		rate;					// Position: vx, vy, vz (m/s). Attitude: roll, pitch, yaw rates (rad/s)
+};
+
+
+/* Classes */
+// Bounded single producer, single consumer ring. The producer (socket thread) and consumer (render thread)
+// each own one index, so neither side takes a lock and the storage is allocated once up front.
+template <typename T, size_t Capacity>
+class SpscQueue {
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+	/* Constructor */
+	SpscQueue() : head(0), tailCache(0), tail(0), headCache(0), dropped(0) {}
+
+	/* Functions */
+	// Producer side, returns false (and counts the drop) if the consumer has fallen a full ring behind
+	bool push(const T& item) {
+		size_t currHead = head.load(std::memory_order_relaxed);
+		if(currHead - tailCache == Capacity) {
+			tailCache = tail.load(std::memory_order_acquire);
+			if(currHead - tailCache == Capacity) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+		}
+		buffer[currHead & (Capacity - 1)] = item;
+		head.store(currHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side, returns false if the queue is empty
+	bool pop(T& item) {
+		size_t currTail = tail.load(std::memory_order_relaxed);
+		if(currTail == headCache) {
+			headCache = head.load(std::memory_order_acquire);
+			if(currTail == headCache) {
+				return false;
+			}
+		}
+		item = buffer[currTail & (Capacity - 1)];
+		tail.store(currTail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Approximate number of queued items, callable from either side
+	size_t size() const {
+		return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+	}
+
+	// Number of items rejected because the queue was full
+	uint64_t droppedCount() const {
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	/* Data */
+	// Producer owned (head written, tail cached), padded onto its own cache line
+	std::atomic<size_t>				head;
+	size_t							tailCache;
+	char							padProducer[64 - sizeof(size_t) - sizeof(std::atomic<size_t>)];
+	// Consumer owned (tail written, head cached)
+	std::atomic<size_t>				tail;
+	size_t							headCache;
+	char							padConsumer[64 - sizeof(size_t) - sizeof(std::atomic<size_t>)];
+	// Statistics
+	std::atomic<uint64_t>			dropped;
+	// Storage
+	T								buffer[Capacity];
+};
+
+typedef SpscQueue<TelemetrySample, TELEMETRY_QUEUE_LENGTH> TelemetryQueue;
+
+
+#endif /* TELEMETRYQUEUE_H_ */
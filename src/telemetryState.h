@@ -0,0 +1,223 @@
+/*
+ * telemetryState.h
+ */
+
+#ifndef TELEMETRYSTATE_H_
+#define TELEMETRYSTATE_H_
+
+// Standard Includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Project Includes
+#include "telemetryQueue.h"
+
+#define TELEMETRY_BUS_RING_LENGTH	2048		// Samples kept per aircraft on the shared memory bus (power of two)
+#define TELEMETRY_BUS_NAME_LENGTH	32
+
+// Valid field flags
+#define TELEM_STATE_VFR_HUD		(1 << 0)
+#define TELEM_STATE_HEARTBEAT	(1 << 1)
+#define TELEM_STATE_SYS_STATUS	(1 << 2)
+#define TELEM_STATE_GPS			(1 << 3)
+#define TELEM_STATE_BATTERY		(1 << 4)
+
+
+/* Structures */
+// Latest value of the slow changing vehicle state, one cache line per aircraft. Unlike position and
+// attitude these aren't interpolated, so only the newest value is kept.
+struct TelemetryState {
+	// VFR_HUD
+	float		airspeed;				// (m/s)
+	float		groundspeed;			// (m/s)
+	float		heading;				// (rad)
+	float		altitude;				// MSL (m)
+	float		climb;					// (m/s)
+	// Battery (SYS_STATUS, BATTERY_STATUS)
+	float		batteryVoltage;			// (V)
+	float		batteryCurrent;			// (A), -1 if not measured
+	// GPS_RAW_INT
+	float		gpsHdop;				// -1 if unknown
+	// HEARTBEAT
+	float		timeHeartbeat;			// Local time of the last autopilot heartbeat (s)
+	uint32_t	customMode;				// Autopilot specific flight mode
+	// SYS_STATUS
+	uint32_t	sensorsEnabled;			// MAV_SYS_STATUS_SENSOR bits
+	uint32_t	sensorsHealth;
+	uint16_t	throttle;				// (%)
+	uint16_t	load;					// Autopilot main loop load (per mille)
+	uint16_t	fieldsValid;			// TELEM_STATE_ flags of the messages seen so far
+	int8_t		batteryRemaining;		// (%), -1 if unknown
+	uint8_t		gpsFixType;				// GPS_FIX_TYPE
+	uint8_t		gpsSatellites;			// 255 if unknown
+	uint8_t		baseMode;				// MAV_MODE_FLAG bits
+	uint8_t		systemStatus;			// MAV_STATE
+	uint8_t		vehicleType;			// MAV_TYPE
+};
+
+/* Classes */
+// Sequence lock around a small trivially copyable block. One writer (the ingest thread) never waits,
+// readers copy the block and retry if a write overlapped. The sequence doubles as a version, so a
+// reader can tell whether anything changed since its last copy.
+template <typename T>
+class Seqlock {
+public:
+	/* Constructor */
+	Seqlock() : sequence(0) {
+		memset((void*)&data, 0, sizeof(data));
+	}
+
+	/* Functions */
+	// Writer side, applies an update function to the block in place
+	template <typename Update>
+	void write(Update update) {
+		uint32_t seq = sequence.load(std::memory_order_relaxed);
+		sequence.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		update(data);
+		sequence.store(seq + 2, std::memory_order_release);
+	}
+
+	// Reader side, returns the version of the copy (always even)
+	uint32_t read(T& copy) const {
+		uint32_t before, after;
+		do {
+			before = sequence.load(std::memory_order_acquire);
+			memcpy(&copy, (const void*)&data, sizeof(T));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = sequence.load(std::memory_order_relaxed);
+		} while((before & 1) || before != after);
+		return before;
+	}
+
+	// Current version, to skip the copy when nothing has changed
+	uint32_t version() const {
+		return sequence.load(std::memory_order_acquire) & ~1u;
+	}
+
+private:
+	/* Data */
+	std::atomic<uint32_t>	sequence;
+	T						data;
+};
+
+typedef Seqlock<TelemetryState> TelemetryBlock;
+static_assert(sizeof(TelemetryBlock) <= 64, "TelemetryState should fit one cache line with its sequence");
+typedef Seqlock<TelemetrySample> LatestSample;
+
+// Single writer ring that any number of readers follow with their own cursor, so it can live in shared
+// memory. The writer never waits; each entry carries a sequence so a reader that is lapped, or races
+// the writer on an entry, notices and skips ahead instead of reading a torn sample.
+template <typename T, size_t Capacity>
+class BroadcastRing {
+	static_assert((Capacity & (Capacity - 1)) == 0, "BroadcastRing capacity must be a power of two");
+
+public:
+	/* Constructor */
+	BroadcastRing() : head(0) {
+		for(size_t i=0; i<Capacity; i++) {
+			entries[i].sequence.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	/* Functions */
+	// Writer side
+	void push(const T& item) {
+		uint64_t currHead = head.load(std::memory_order_relaxed);
+		Entry& entry = entries[currHead & (Capacity - 1)];
+		entry.sequence.store(2*currHead + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		entry.item = item;
+		entry.sequence.store(2*currHead + 2, std::memory_order_release);
+		head.store(currHead + 1, std::memory_order_release);
+	}
+
+	// Reader side, returns false once the cursor has caught up. Samples overwritten before they were
+	// read are added to lost.
+	bool read(uint64_t& cursor, T& item, uint64_t& lost) const {
+		while(true) {
+			uint64_t currHead = head.load(std::memory_order_acquire);
+			if(cursor >= currHead) {
+				return false;
+			}
+			if(currHead - cursor > Capacity) {
+				lost += currHead - cursor - Capacity;
+				cursor = currHead - Capacity;
+			}
+			const Entry& entry = entries[cursor & (Capacity - 1)];
+			uint64_t before = entry.sequence.load(std::memory_order_acquire);
+			memcpy(&item, (const void*)&entry.item, sizeof(T));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t after = entry.sequence.load(std::memory_order_relaxed);
+			cursor++;
+			if(before == after && before == 2*cursor) {
+				return true;
+			}
+			lost++;
+		}
+	}
+
+	// Oldest position a new reader can start from and still get every sample
+	uint64_t oldest() const {
+		uint64_t currHead = head.load(std::memory_order_acquire);
+		return (currHead > Capacity) ? currHead - Capacity : 0;
+	}
+
+private:
+	/* Structures */
+	struct Entry {
+		std::atomic<uint64_t>	sequence;		// 2*index+1 while being written, 2*index+2 once complete
+		T						item;
+	};
+
+	/* Data */
+	std::atomic<uint64_t>	head;
+	char					pad[64 - sizeof(std::atomic<uint64_t>)];
+	Entry					entries[Capacity];
+};
+
+// One aircraft on the shared memory bus
+struct BusAircraft {
+	char				name[TELEMETRY_BUS_NAME_LENGTH];
+	BroadcastRing<TelemetrySample, TELEMETRY_BUS_RING_LENGTH> samples;
+	TelemetryBlock		state;
+	LatestSample		latest[TELEM_TYPE_COUNT];
+};
+
+// Everything the ingest thread hands to one aircraft: samples to interpolate and the latest state.
+// Messages with a latest only ingest policy overwrite a single slot per sample type instead of
+// queueing. When busPt is set (ingest process) everything goes to the shared memory bus instead.
+struct TelemetryChannel {
+	TelemetryQueue		queue;
+	TelemetryBlock		state;
+	LatestSample		latest[TELEM_TYPE_COUNT];
+	BusAircraft*		busPt = nullptr;
+	bool				latestOnly = false;		// Set by the ingest thread around a latest only message
+
+	void publish(const TelemetrySample& sample) {
+		LatestSample* latestPt = (busPt != nullptr) ? busPt->latest : latest;
+		if(latestOnly) {
+			latestPt[sample.type].write([&sample](TelemetrySample& slot) {
+				slot = sample;
+			});
+		} else if(busPt != nullptr) {
+			busPt->samples.push(sample);
+		} else {
+			queue.push(sample);
+		}
+	}
+
+	template <typename Update>
+	void writeState(Update update) {
+		if(busPt != nullptr) {
+			busPt->state.write(update);
+		} else {
+			state.write(update);
+		}
+	}
+};
+
+
+#endif /* TELEMETRYSTATE_H_ */
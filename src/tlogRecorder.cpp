@@ -0,0 +1,188 @@
+/*
+ * tlogRecorder.cpp
+ */
+
+#include "tlogRecorder.h"
+
+// Standard Includes
+#include <cstdio>
+#include <ctime>
+#include <chrono>
+#include <cstring>
+
+// System Includes
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// Boost Includes
+#include <boost/filesystem.hpp>
+
+
+/* Constructor */
+TlogRecorder::TlogRecorder(std::string directory, std::string prefix, size_t segmentSize) : nextSegment(nullptr), running(true) {
+	this->directory = directory;
+	this->prefix = prefix;
+	this->segmentSize = segmentSize;
+
+	// Create the first segment up front, the recorder thread prepares the rest
+	boost::filesystem::create_directories(directory);
+	current = createSegment();
+	active = current;
+	recorderThread = std::thread(&TlogRecorder::recorderLoop, this);
+}
+
+TlogRecorder::~TlogRecorder() {
+	// Stop the recorder thread, then close everything it hasn't
+	running = false;
+	recorderThread.join();
+	TlogSegment* segment;
+	while(retiredSegments.pop(segment)) {
+		closeSegment(segment);
+	}
+	if(current != nullptr) {
+		closeSegment(current);
+	}
+	segment = nextSegment.exchange(nullptr);
+	if(segment != nullptr) {
+		// Never written, remove the empty file
+		std::string path = segment->path;
+		closeSegment(segment);
+		unlink(path.c_str());
+	}
+}
+
+/* Functions */
+bool TlogRecorder::writeFrame(uint64_t timeUsec, const uint8_t* frame, size_t length) {
+	// Called from the ingest thread, only copies into mapped memory
+	if(current == nullptr || length > MAVLINK_MAX_PACKET_LEN) {
+		droppedFrames++;
+		return false;
+	}
+	size_t offset = current->used.load(std::memory_order_relaxed);
+	if(offset + TLOG_RECORD_MAX_LENGTH > current->size) {
+		// Roll over to the prepared segment, dropping the frame if it isn't ready yet or the recorder
+		// thread is so far behind that it has no room for another full segment
+		if(nextSegment.load() == nullptr || !retiredSegments.push(current)) {
+			droppedFrames++;
+			return false;
+		}
+		current = nextSegment.exchange(nullptr);
+		offset = 0;
+	}
+
+	// Big endian timestamp
+	uint8_t* record = current->data + offset;
+	for(int i=0; i<8; i++) {
+		record[i] = (timeUsec >> (56 - 8*i)) & 0xFF;
+	}
+
+	// Frame as received
+	memcpy(record + 8, frame, length);
+	current->used.store(offset + 8 + length, std::memory_order_release);
+	recordedFrames++;
+
+	return true;
+}
+
+TlogSegment* TlogRecorder::createSegment() {
+	// Name segments by start time and sequence number
+	char timeStr[32];
+	time_t now = time(nullptr);
+	struct tm localTime;
+	localtime_r(&now, &localTime);
+	strftime(timeStr, sizeof(timeStr), "%Y%m%d_%H%M%S", &localTime);
+	char name[64];
+	snprintf(name, sizeof(name), "_%s_%03i.tlog", timeStr, segmentCount++);
+	std::string path = directory + "/" + prefix + name;
+
+	// Open and reserve the full segment on disk so writes through the map can't fail
+	int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0) {
+		perror(("Could not create " + path).c_str());
+		return nullptr;
+	}
+	if(posix_fallocate(fd, 0, segmentSize) != 0) {
+		printf("ERROR: Could not allocate %lu bytes for %s\n", (unsigned long)segmentSize, path.c_str());
+		close(fd);
+		return nullptr;
+	}
+	void* data = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(data == MAP_FAILED) {
+		perror(("Could not map " + path).c_str());
+		close(fd);
+		return nullptr;
+	}
+
+	TlogSegment* segment = new TlogSegment();
+	segment->path = path;
+	segment->fd = fd;
+	segment->data = (uint8_t*)data;
+	segment->size = segmentSize;
+	segment->used = 0;
+	segment->synced = 0;
+	printf("Recording tlog: %s\n", path.c_str());
+
+	return segment;
+}
+
+void TlogRecorder::syncSegment(TlogSegment* segment) {
+	// Flush everything written since the last sync, starting from a page boundary
+	size_t used = segment->used.load(std::memory_order_acquire);
+	if(used > segment->synced) {
+		size_t pageSize = sysconf(_SC_PAGESIZE);
+		size_t start = (segment->synced / pageSize) * pageSize;
+		msync(segment->data + start, used - start, MS_SYNC);
+		segment->synced = used;
+	}
+}
+
+void TlogRecorder::closeSegment(TlogSegment* segment) {
+	// Flush, then trim the pre-allocated tail
+	syncSegment(segment);
+	size_t used = segment->used.load(std::memory_order_acquire);
+	munmap(segment->data, segment->size);
+	if(ftruncate(segment->fd, used) != 0) {
+		perror(("Could not truncate " + segment->path).c_str());
+	}
+	close(segment->fd);
+	delete segment;
+}
+
+void TlogRecorder::recorderLoop() {
+	std::chrono::steady_clock::time_point lastSync = std::chrono::steady_clock::now();
+	while(running) {
+		// Once the ingest thread takes the prepared segment it becomes the active one
+		if(nextSegment.load() == nullptr) {
+			if(handedOut != nullptr) {
+				active = handedOut;
+				handedOut = nullptr;
+			}
+			TlogSegment* segment = createSegment();
+			if(segment != nullptr) {
+				handedOut = segment;
+				nextSegment.store(segment);
+			}
+		}
+
+		// Close full segments
+		TlogSegment* retired;
+		while(retiredSegments.pop(retired)) {
+			if(retired == active) {
+				active = nullptr;
+			}
+			closeSegment(retired);
+		}
+
+		// Batch flushes of the active segment
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if(std::chrono::duration<double>(now - lastSync).count() > TLOG_SYNC_PERIOD) {
+			if(active != nullptr) {
+				syncSegment(active);
+			}
+			lastSync = now;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	}
+}
@@ -0,0 +1,75 @@
+/*
+ * tlogRecorder.h
+ */
+
+#ifndef TLOGRECORDER_H_
+#define TLOGRECORDER_H_
+
+// Standard Includes
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+// Mavlink Includes
+#include <c_library_v2/ardupilotmega/mavlink.h>
+
+// Project Includes
+#include "telemetryQueue.h"
+
+#define TLOG_SEGMENT_SIZE		(64*1024*1024)	// Pre-allocated size of each tlog segment (bytes)
+#define TLOG_SYNC_PERIOD		1.0				// Time between flushes of written data to disk (s)
+#define TLOG_RECORD_MAX_LENGTH	(8 + MAVLINK_MAX_PACKET_LEN)
+
+
+/* Structures */
+struct TlogSegment {
+	std::string				path;
+	int						fd;
+	uint8_t*				data;
+	size_t					size;
+	std::atomic<size_t>		used;			// Bytes written by the ingest thread
+	size_t					synced;			// Bytes flushed by the recorder thread
+};
+
+/* Classes */
+// Append only tlog writer. Each record is a big endian uint64 receive time (us since the Unix epoch)
+// followed by the MAVLink frame exactly as received, copied straight into a memory mapped, pre-allocated segment. A
+// background thread creates the next segment ahead of time, flushes written data in batches and
+// truncates full segments, so the ingest thread never waits on the file system.
+class TlogRecorder {
+public:
+	/* Data */
+	uint64_t recordedFrames = 0;
+	uint64_t droppedFrames = 0;
+
+	/* Constructor */
+	TlogRecorder(std::string directory, std::string prefix, size_t segmentSize = TLOG_SEGMENT_SIZE);
+	~TlogRecorder();
+
+	/* Functions */
+	bool writeFrame(uint64_t timeUsec, const uint8_t* frame, size_t length);
+
+private:
+	/* Data */
+	std::string directory;
+	std::string prefix;
+	size_t segmentSize;
+	int segmentCount = 0;
+	TlogSegment* current = nullptr;						// Owned by the ingest thread
+	std::atomic<TlogSegment*> nextSegment;				// Prepared by the recorder thread
+	SpscQueue<TlogSegment*, 16> retiredSegments;		// Full segments waiting to be truncated and closed
+	TlogSegment* active = nullptr;						// Segment being written, as seen by the recorder thread
+	TlogSegment* handedOut = nullptr;					// Prepared segment not yet taken by the ingest thread
+	std::atomic<bool> running;
+	std::thread recorderThread;
+
+	/* Functions */
+	TlogSegment* createSegment();
+	void syncSegment(TlogSegment* segment);
+	void closeSegment(TlogSegment* segment);
+	void recorderLoop();
+};
+
+
+#endif /* TLOGRECORDER_H_ */
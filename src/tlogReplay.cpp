@@ -0,0 +1,103 @@
+/*
+ * tlogReplay.cpp
+ */
+
+#include "tlogReplay.h"
+
+
+/* Constructor */
+TlogReplay::TlogReplay(std::string path, MavSocket* mavSocketPt, PlaybackClock* clockPt) : MavReplay(path, clockPt) {
+	this->mavSocketPt = mavSocketPt;
+}
+
+TlogReplay::~TlogReplay() {
+	stop();
+}
+
+/* Functions */
+bool TlogReplay::openFile() {
+	if(!mapFile()) {
+		return false;
+	}
+
+	// Find the first record, the duration and the seek points
+	size_t frameLen;
+	uint64_t timeUsec;
+	while(offset < size && !readRecord(offset, &firstTimeUsec, &frameLen)) {
+		offset++;
+	}
+	size_t at = offset;
+	uint64_t lastTimeUsec = firstTimeUsec;
+	while(at < size) {
+		if(readRecord(at, &timeUsec, &frameLen)) {
+			lastTimeUsec = timeUsec;
+			indexRecord(timeUsec, at);
+			at += 8 + frameLen;
+		} else {
+			at++;
+		}
+		releaseBefore(at);
+	}
+	releaseAll();
+	duration = (lastTimeUsec - firstTimeUsec)/1e6;
+	printf("Replaying %s: %.1f s of telemetry\n", path.c_str(), duration);
+
+	return true;
+}
+
+bool TlogReplay::readRecord(size_t at, uint64_t* timeUsec, size_t* frameLen) {
+	// Reads the big endian timestamp and works out the length of the frame that follows
+	if(at + 8 + 8 > size) {
+		return false;
+	}
+	uint64_t t = 0;
+	for(int i=0; i<8; i++) {
+		t = (t << 8) | data[at + i];
+	}
+	const uint8_t* frame = data + at + 8;
+	size_t len;
+	if(frame[0] == MAVLINK_STX) {
+		// v2: header, payload, checksum and optional signature
+		len = 10 + frame[1] + 2 + ((frame[2] & 0x01) ? 13 : 0);
+	} else if(frame[0] == MAVLINK_STX_MAVLINK1) {
+		len = 6 + frame[1] + 2;
+	} else {
+		return false;
+	}
+	if(at + 8 + len > size) {
+		return false;
+	}
+	*timeUsec = t;
+	*frameLen = len;
+	return true;
+}
+
+bool TlogReplay::peekRecord(ReplayRecord* record) {
+	// Skip corrupt bytes until the next valid record
+	uint64_t timeUsec;
+	while(offset < size && !readRecord(offset, &timeUsec, &frameLen)) {
+		offset++;
+	}
+	if(offset >= size) {
+		return false;
+	}
+	record->timeUsec = timeUsec;
+	record->data = data + offset + 8;
+	record->length = frameLen;
+	record->socketPt = mavSocketPt;
+	record->senderKey = 0;
+	return true;
+}
+
+void TlogReplay::consumeRecord() {
+	offset += 8 + frameLen;
+	releaseBefore(offset);
+}
+
+bool TlogReplay::backlogged() {
+	return mavSocketPt->backlogged();
+}
+
+void TlogReplay::seekToPoint(size_t point) {
+	offset = seekIndex[point].offset;
+}
@@ -0,0 +1,45 @@
+/*
+ * tlogReplay.h
+ */
+
+#ifndef TLOGREPLAY_H_
+#define TLOGREPLAY_H_
+
+// Standard Includes
+#include <string>
+#include <cstdint>
+
+// Project Includes
+#include "mavReplay.h"
+
+
+/* Classes */
+// Feeds a recorded tlog through a MavSocket's parse and decode path, paced by the playback clock.
+class TlogReplay : public MavReplay {
+public:
+	/* Constructor */
+	TlogReplay(std::string path, MavSocket* mavSocketPt, PlaybackClock* clockPt);
+	~TlogReplay();
+
+	/* Functions */
+	bool openFile();
+
+protected:
+	/* Functions */
+	bool peekRecord(ReplayRecord* record);
+	void consumeRecord();
+	bool backlogged();
+	void seekToPoint(size_t point);
+
+private:
+	/* Data */
+	MavSocket* mavSocketPt;
+	size_t offset = 0;
+	size_t frameLen = 0;					// Length of the frame at offset once peeked
+
+	/* Functions */
+	bool readRecord(size_t at, uint64_t* timeUsec, size_t* frameLen);
+};
+
+
+#endif /* TLOGREPLAY_H_ */
@@ -0,0 +1,253 @@
+/*
+ * mavBench.cpp
+ *
+ *  Ingest microbenchmarks. Prints one JSON object per line:
+ *    parse_decode       MavParser + registered message handler, ns per message on one core
+ *    process_datagram   MavSocket::processDatagram (parse, route, queue push), ns per message
+ *    arrival_to_visible loopback UDP through MavReactor to a consumer draining at the frame rate, us
+ *  Arrival to drawn latency needs a window, it is written by openGLMap -l <file>.
+ */
+
+// Standard Includes
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+// Socket Includes
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Project Includes
+#include "../mavlinkReceive.h"
+#include "../mavReactor.h"
+#include "../latencyHistogram.h"
+#include "../playbackClock.h"
+
+#define BENCH_FRAME_COUNT		3000		// Distinct generated frames (position, attitude, VFR_HUD)
+#define BENCH_TIMING_BLOCK		256			// Messages timed together in the throughput loops
+
+typedef std::chrono::steady_clock benchClock;
+
+
+/* Structures */
+struct BenchFrame {
+	uint8_t		data[MAVLINK_MAX_PACKET_LEN];
+	uint16_t	length;
+};
+
+/* Functions */
+void printUsage() {
+	printf("Usage: mavBench [-n messages] [-r rate Hz] [-t seconds] [-f frame rate Hz] [-p port] [-o file]\n");
+	printf("  -n  Messages decoded per throughput test (default 5000000)\n");
+	printf("  -r  Loopback send rate in messages per second (default 10000)\n");
+	printf("  -t  Loopback run time (default 5 s)\n");
+	printf("  -f  Consumer drain rate, 0 drains continuously (default 60 Hz)\n");
+	printf("  -p  Loopback port (default 14599)\n");
+	printf("  -o  Append results to a file instead of stdout\n");
+}
+
+std::vector<BenchFrame> generateFrames() {
+	// A repeating mix of the three messages the viewer decodes, with valid sequence numbers
+	std::vector<BenchFrame> frames(BENCH_FRAME_COUNT);
+	mavlink_status_t* txStatus = mavlink_get_channel_status(MAVLINK_COMM_0);
+	mavlink_message_t msg;
+	for(int i=0; i<BENCH_FRAME_COUNT; i++) {
+		uint32_t timeBootMs = 20*i;
+		txStatus->current_tx_seq = i & 0xFF;
+		switch(i % 3) {
+			case 0:
+				mavlink_msg_global_position_int_pack(1, 1, &msg, timeBootMs, -379589260 + i, 1452383430 + i, 100000, 50000 + i, 150, -20, 5, 9000);
+				break;
+			case 1:
+				mavlink_msg_attitude_pack(1, 1, &msg, timeBootMs, 0.1f, 0.05f, 1.57f, 0.01f, 0.02f, 0.03f);
+				break;
+			case 2:
+				mavlink_msg_vfr_hud_pack(1, 1, &msg, 15.0f, 15.5f, 90, 50, 50.0f, 0.2f);
+				break;
+		}
+		frames[i].length = mavlink_msg_to_send_buffer(frames[i].data, &msg);
+	}
+	return frames;
+}
+
+void writeThroughput(FILE* out, const char* name, uint64_t messages, uint64_t bytes, double seconds) {
+	fprintf(out,"{\"name\":\"%s_throughput\",\"messages\":%llu,\"seconds\":%.3f,\"messages_per_second\":%.0f,\"megabytes_per_second\":%.1f}\n",
+			name, (unsigned long long)messages, seconds, messages/seconds, bytes/seconds/1e6);
+}
+
+void benchParseDecode(FILE* out, const std::vector<BenchFrame>& frames, uint64_t numMessages) {
+	// Raw framing and decode cost per core
+	LatencyHistogram histogram("parse_decode", "ns");
+	MavParser parser;
+	mavlink_message_t msg;
+	TelemetryChannel channel;
+	TelemetrySample sample;
+	uint64_t decoded = 0, bytes = 0, blockStart = 0;
+	benchClock::time_point start = benchClock::now();
+	benchClock::time_point blockTime = start;
+	for(uint64_t i=0; decoded < numMessages; i++) {
+		const BenchFrame& frame = frames[i % frames.size()];
+		for(int j=0; j<frame.length; j++) {
+			if(parser.parseChar(frame.data[j], &msg)) {
+				MavHandler handler = mavHandlerRegistry.find(msg.msgid);
+				if(handler != nullptr) {
+					handler(&msg, &channel, 0);
+				}
+				decoded++;
+			}
+		}
+		while(channel.queue.pop(sample)) {}
+		bytes += frame.length;
+
+		// Time blocks of messages so the clock reads do not dominate
+		if(decoded - blockStart >= BENCH_TIMING_BLOCK) {
+			benchClock::time_point now = benchClock::now();
+			histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - blockTime).count()/(decoded - blockStart));
+			blockTime = now;
+			blockStart = decoded;
+		}
+	}
+	double seconds = std::chrono::duration<double>(benchClock::now() - start).count();
+	writeThroughput(out, "parse_decode", decoded, bytes, seconds);
+	histogram.writeJson(out);
+}
+
+void benchProcessDatagram(FILE* out, const std::vector<BenchFrame>& frames, uint64_t numMessages) {
+	// Full socket path per datagram: per sender parser, routing and queue push
+	LatencyHistogram histogram("process_datagram", "ns");
+	TelemetryChannel channel;
+	MavSocket mavSocket("127.0.0.1", "0", &channel);
+	TelemetrySample sample;
+	uint64_t delivered = 0, bytes = 0, blockStart = 0;
+	benchClock::time_point start = benchClock::now();
+	benchClock::time_point blockTime = start;
+	for(uint64_t i=0; delivered < numMessages; i++) {
+		const BenchFrame& frame = frames[i % frames.size()];
+		mavSocket.processDatagram(frame.data, frame.length, 0, 0, 0);
+		bytes += frame.length;
+		while(channel.queue.pop(sample)) {}
+		delivered = mavSocket.health->messages.get();
+
+		// Time blocks of messages so the clock reads do not dominate
+		if(delivered - blockStart >= BENCH_TIMING_BLOCK) {
+			benchClock::time_point now = benchClock::now();
+			histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - blockTime).count()/(delivered - blockStart));
+			blockTime = now;
+			blockStart = delivered;
+		}
+	}
+	double seconds = std::chrono::duration<double>(benchClock::now() - start).count();
+	writeThroughput(out, "process_datagram", delivered, bytes, seconds);
+	histogram.writeJson(out);
+}
+
+void benchLoopback(FILE* out, const std::vector<BenchFrame>& frames, int port, double rate, double runTime, double frameRate) {
+	// Datagram arrival (MavSocket timeReceived) to the sample being popped by a render rate consumer
+	LatencyHistogram histogram("arrival_to_visible", "us");
+	TelemetryChannel channel;
+	MavSocket mavSocket("127.0.0.1", std::to_string(port), &channel);
+	MavReactor mavReactor;
+	mavReactor.addSocket(&mavSocket);
+	mavReactor.start();
+
+	// Sender
+	std::atomic<bool> sending(true);
+	std::thread sender([&]() {
+		int sock = socket(AF_INET, SOCK_DGRAM, 0);
+		sockaddr_in destination;
+		memset(&destination, 0, sizeof(destination));
+		destination.sin_family = AF_INET;
+		destination.sin_port = htons(port);
+		inet_pton(AF_INET, "127.0.0.1", &destination.sin_addr);
+		benchClock::time_point start = benchClock::now();
+		uint64_t sent = 0;
+		while(sending) {
+			// Send everything due since the start, then sleep briefly
+			double elapsed = std::chrono::duration<double>(benchClock::now() - start).count();
+			uint64_t due = (uint64_t)(elapsed*rate);
+			for(; sent < due; sent++) {
+				const BenchFrame& frame = frames[sent % frames.size()];
+				sendto(sock, frame.data, frame.length, 0, (sockaddr*)&destination, sizeof(destination));
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+		close(sock);
+	});
+
+	// Consumer
+	TelemetrySample sample;
+	uint64_t received = 0;
+	benchClock::time_point start = benchClock::now();
+	benchClock::time_point nextFrame = start;
+	while(std::chrono::duration<double>(benchClock::now() - start).count() < runTime) {
+		if(frameRate > 0) {
+			nextFrame += std::chrono::microseconds((int64_t)(1e6/frameRate));
+			std::this_thread::sleep_until(nextFrame);
+		} else {
+			std::this_thread::yield();
+		}
+		double timeDrained = playbackClock.now();
+		while(channel.queue.pop(sample)) {
+			histogram.recordSeconds(timeDrained - sample.timeReceived);
+			received++;
+		}
+	}
+	sending = false;
+	sender.join();
+	mavReactor.stop();
+
+	fprintf(out,"{\"name\":\"loopback\",\"rate\":%.0f,\"frame_rate\":%.1f,\"messages\":%llu,\"expected\":%.0f,\"samples\":%llu,\"queue_drops\":%llu}\n",
+			rate, frameRate, (unsigned long long)mavSocket.health->messages.get(), rate*runTime, (unsigned long long)received,
+			(unsigned long long)channel.queue.droppedCount());
+	histogram.writeJson(out);
+}
+
+int main(int argc, char* argv[]) {
+	/* Command Line Arguments */
+	uint64_t numMessages = 5000000;
+	double rate = 10000;
+	double runTime = 5.0;
+	double frameRate = 60.0;
+	int port = 14599;
+	std::string outPath;
+	int opt;
+	while((opt = getopt(argc, argv, "n:r:t:f:p:o:h")) != -1) {
+		switch(opt) {
+		case 'n': numMessages = strtoull(optarg, NULL, 10); break;
+		case 'r': rate = atof(optarg); break;
+		case 't': runTime = atof(optarg); break;
+		case 'f': frameRate = atof(optarg); break;
+		case 'p': port = atoi(optarg); break;
+		case 'o': outPath = optarg; break;
+		default: printUsage(); return 1;
+		}
+	}
+
+	/* Output */
+	FILE* out = stdout;
+	if(!outPath.empty()) {
+		out = fopen(outPath.c_str(), "a");
+		if(out == NULL) {
+			printf("ERROR: Could not open %s.\n", outPath.c_str());
+			return 1;
+		}
+	}
+
+	/* Benchmarks */
+	std::vector<BenchFrame> frames = generateFrames();
+	benchParseDecode(out, frames, numMessages);
+	benchProcessDatagram(out, frames, numMessages);
+	benchLoopback(out, frames, port, rate, runTime, frameRate);
+
+	if(out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}
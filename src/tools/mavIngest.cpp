@@ -0,0 +1,125 @@
+/*
+ * mavIngest.cpp
+ *
+ *  Headless ingest process. Receives every configured link, decodes once and publishes samples and
+ *  vehicle state to a shared memory telemetry bus that any number of openGLMap viewers (-b) read.
+ */
+
+// Standard Includes
+#include <string>
+#include <vector>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+// Project Includes
+#include "../settings.h"
+#include "../mavlinkReceive.h"
+#include "../mavReactor.h"
+#include "../telemetryBus.h"
+
+
+/* Data */
+volatile sig_atomic_t running = 1;
+
+/* Functions */
+void printUsage() {
+	printf("Usage: mavIngest [-c config] [-b bus] [-r] [-f]\n");
+	printf("  -c  Config file with the aircraft links (default ../Configs/currentConfig.txt)\n");
+	printf("  -b  Shared memory bus name (default %s)\n", TELEMETRY_BUS_DEFAULT_NAME);
+	printf("  -r  Record tlogs to ../Logs\n");
+	printf("  -f  Replace the bus even if another mavIngest is still writing it\n");
+}
+
+void handleSignal(int signal) {
+	running = 0;
+}
+
+int main(int argc, char* argv[]) {
+	/* Command Line Arguments */
+	std::string configPath = "../Configs/currentConfig.txt";
+	std::string busName = TELEMETRY_BUS_DEFAULT_NAME;
+	bool recordOn = false;
+	bool replaceBus = false;
+	int opt;
+	while((opt = getopt(argc, argv, "c:b:rfh")) != -1) {
+		switch(opt) {
+		case 'c': configPath = optarg; break;
+		case 'b': busName = optarg; break;
+		case 'r': recordOn = true; break;
+		case 'f': replaceBus = true; break;
+		default: printUsage(); return 1;
+		}
+	}
+	Settings settings(configPath.c_str());
+
+	/* Bus */
+	TelemetryBus telemetryBus;
+	std::vector<std::string> names;
+	for(unsigned int i=0; i<settings.aircraftConList.size(); i++) {
+		names.push_back(settings.aircraftConList[i].name);
+	}
+	if(!telemetryBus.create(busName, names, replaceBus)) {
+		return 1;
+	}
+
+	/* Links */
+	int num = settings.aircraftConList.size();
+	std::vector<TelemetryChannel> channelList(num);
+	std::vector<MavSocket> mavSocketList;
+	mavSocketList.reserve(num);
+	MavReactor mavReactor;
+	for(unsigned int i=0; i<settings.aircraftConList.size(); i++) {
+		// Publish straight to this aircraft's bus slot
+		channelList[i].busPt = telemetryBus.aircraft(i);
+		// Find or create the socket for this address and port
+		MavSocket* mavSocketPt = nullptr;
+		for(unsigned int j=0; j<mavSocketList.size(); j++) {
+			if(mavSocketList[j].host == settings.aircraftConList[i].ipString && mavSocketList[j].port == settings.aircraftConList[i].port) {
+				mavSocketPt = &mavSocketList[j];
+			}
+		}
+		if(mavSocketPt == nullptr) {
+			mavSocketList.push_back(MavSocket(settings.aircraftConList[i].ipString, settings.aircraftConList[i].port));
+			mavSocketPt = &mavSocketList.back();
+		}
+		// Route messages to this aircraft by sysid, or take everything on the port
+		if(settings.aircraftConList[i].sysid > 0) {
+			mavSocketPt->addRoute(settings.aircraftConList[i].sysid, 0, &channelList[i]);
+		} else {
+			if(mavSocketPt->defaultChannelPt != nullptr) {
+				printf("WARNING: %s shares port %s without a sysid, replacing the previous aircraft.\n",settings.aircraftConList[i].name.c_str(),mavSocketPt->port.c_str());
+			}
+			mavSocketPt->defaultChannelPt = &channelList[i];
+		}
+	}
+	for(unsigned int i=0; i<mavSocketList.size(); i++) {
+		if(recordOn) {
+			mavSocketList[i].enableRecording("../Logs");
+		}
+		for(unsigned int j=0; j<settings.forwardList.size(); j++) {
+			if(settings.forwardList[j].linkPort == mavSocketList[i].port) {
+				mavSocketList[i].addForward(settings.forwardList[j].ipString, settings.forwardList[j].port);
+			}
+		}
+		for(unsigned int j=0; j<settings.ingestList.size(); j++) {
+			if(settings.ingestList[j].linkPort == mavSocketList[i].port) {
+				mavSocketList[i].setIngestPolicy(settings.ingestList[j].message, settings.ingestList[j].policy);
+			}
+		}
+		mavReactor.addSocket(&mavSocketList[i]);
+	}
+
+	/* Run */
+	signal(SIGINT, handleSignal);
+	signal(SIGTERM, handleSignal);
+	mavReactor.start();
+	while(running) {
+		usleep(100000);
+	}
+	printf("\nStopping ingest.\n");
+	mavReactor.stop();
+	telemetryBus.close();
+	return 0;
+}
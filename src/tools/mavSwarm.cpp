@@ -0,0 +1,243 @@
+/*
+ * mavSwarm.cpp
+ *
+ *  Synthetic MAVLink swarm for load testing. Streams GLOBAL_POSITION_INT, ATTITUDE and VFR_HUD
+ *  (plus a 1 Hz HEARTBEAT) for N vehicles circling the configured origin.
+ */
+
+// Standard Includes
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+// Socket Includes
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Mavlink Includes
+#include <c_library_v2/ardupilotmega/mavlink.h>
+
+// Project Includes
+#include "../settings.h"
+
+#define SWARM_MAX_FRAMES	4				// Frames sent per vehicle per tick
+#define EARTH_RADIUS		6378137.0		// (m)
+#define GRAVITY				9.81			// (m/s^2)
+
+
+/* Structures */
+struct SwarmVehicle {
+	uint8_t		sysid;
+	uint8_t		seq;						// Own MAVLink sequence number
+	uint32_t	bootOffsetMs;				// Vehicles boot at different times
+	double		centreNorth;				// Circle centre relative to origin (m)
+	double		centreEast;
+	double		radius;						// (m)
+	double		speed;						// (m/s)
+	double		alt;						// Relative altitude (m)
+	double		phase;						// Starting angle (rad)
+	sockaddr_in	destination;
+};
+
+/* Functions */
+void printUsage() {
+	printf("Usage: mavSwarm [-n vehicles] [-r rate Hz] [-a address] [-p port] [-u] [-b] [-t seconds] [-c config]\n");
+	printf("  -n  Number of simulated vehicles (default 20)\n");
+	printf("  -r  Message rate per vehicle and message type (default 50 Hz)\n");
+	printf("  -a  Destination address (default 127.0.0.1)\n");
+	printf("  -p  Destination port, or first port with -u (default 14550)\n");
+	printf("  -u  Send each vehicle to its own port (port + index) instead of one port with distinct sysids\n");
+	printf("  -b  Bundle each vehicle's frames into one datagram\n");
+	printf("  -t  Run time, 0 runs until killed (default 0)\n");
+	printf("  -c  Config file providing the origin (default ../Configs/currentConfig.txt)\n");
+}
+
+int main(int argc, char* argv[]) {
+	/* Command Line Arguments */
+	int numVehicles = 20;
+	double rate = 50.0;
+	std::string address = "127.0.0.1";
+	int port = 14550;
+	bool uniquePorts = false;
+	bool bundle = false;
+	double runTime = 0;
+	std::string configPath = "../Configs/currentConfig.txt";
+	int opt;
+	while((opt = getopt(argc, argv, "n:r:a:p:ubt:c:h")) != -1) {
+		switch(opt) {
+		case 'n': numVehicles = atoi(optarg); break;
+		case 'r': rate = atof(optarg); break;
+		case 'a': address = optarg; break;
+		case 'p': port = atoi(optarg); break;
+		case 'u': uniquePorts = true; break;
+		case 'b': bundle = true; break;
+		case 't': runTime = atof(optarg); break;
+		case 'c': configPath = optarg; break;
+		default: printUsage(); return 1;
+		}
+	}
+	if(numVehicles < 1 || numVehicles > 254 || rate <= 0) {
+		printf("ERROR: Need 1-254 vehicles and a positive rate.\n");
+		return 1;
+	}
+
+	/* Origin */
+	Settings settings(configPath.c_str());
+	double originLat = settings.origin[0];
+	double originLon = settings.origin[1];
+
+	/* Vehicles */
+	std::vector<SwarmVehicle> vehicles(numVehicles);
+	for(int i=0; i<numVehicles; i++) {
+		SwarmVehicle& v = vehicles[i];
+		v.sysid = i + 1;
+		v.seq = 0;
+		v.bootOffsetMs = 1000*i;
+		// Spread circle centres over a ring around the origin
+		double ringAngle = 2*M_PI*i/numVehicles;
+		double ringRadius = (numVehicles > 1) ? 300.0 : 0.0;
+		v.centreNorth = ringRadius*cos(ringAngle);
+		v.centreEast = ringRadius*sin(ringAngle);
+		v.radius = 100.0 + 15.0*(i % 8);
+		v.speed = 15.0 + (i % 5)*2.5;
+		v.alt = 50.0 + 10.0*(i % 10);
+		v.phase = ringAngle;
+		v.destination.sin_family = AF_INET;
+		v.destination.sin_port = htons(uniquePorts ? port + i : port);
+		inet_pton(AF_INET, address.c_str(), &v.destination.sin_addr);
+	}
+
+	/* Socket */
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if(sock < 0) {
+		perror("socket");
+		return 1;
+	}
+	int sendBuffer = 4*1024*1024;
+	setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+
+	/* Send Buffers */
+	int maxDatagrams = numVehicles*SWARM_MAX_FRAMES;
+	std::vector<uint8_t> frames(maxDatagrams*MAVLINK_MAX_PACKET_LEN);
+	std::vector<struct mmsghdr> headers(maxDatagrams);
+	std::vector<struct iovec> iovecs(maxDatagrams);
+
+	printf("mavSwarm: %i vehicles at %.1f Hz to %s:%i%s around (%f, %f)\n",numVehicles,rate,address.c_str(),port,
+			uniquePorts ? "+" : " (sysid 1-N)",originLat,originLon);
+
+	/* Main Loop */
+	mavlink_status_t* txStatus = mavlink_get_channel_status(MAVLINK_COMM_0);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point nextTick = start;
+	std::chrono::steady_clock::time_point lastReport = start;
+	std::chrono::nanoseconds period((long long)(1e9/rate));
+	uint64_t sentDatagrams = 0, sentFrames = 0, sendCalls = 0, lastHeartbeatSec = (uint64_t)-1;
+	while(true) {
+		double t = std::chrono::duration<double>(nextTick - start).count();
+		if(runTime > 0 && t > runTime) {
+			break;
+		}
+		bool heartbeat = ((uint64_t)t != lastHeartbeatSec);
+		lastHeartbeatSec = (uint64_t)t;
+
+		// Build every vehicle's frames for this tick
+		int numDatagrams = 0;
+		for(int i=0; i<numVehicles; i++) {
+			SwarmVehicle& v = vehicles[i];
+			uint32_t timeBootMs = v.bootOffsetMs + (uint32_t)(t*1000.0);
+
+			// Circular trajectory (clockwise seen from above)
+			double angle = v.phase + v.speed*t/v.radius;
+			double north = v.centreNorth + v.radius*cos(angle);
+			double east = v.centreEast + v.radius*sin(angle);
+			double vNorth = -v.speed*sin(angle);
+			double vEast = v.speed*cos(angle);
+			double climb = 2.0*sin(0.1*t + i);
+			double alt = v.alt + 20.0*(1 - cos(0.1*t + i));
+			double course = atan2(vEast, vNorth);
+			double roll = atan(v.speed*v.speed/(v.radius*GRAVITY));
+			double pitch = atan2(climb, v.speed);
+			double yawRate = v.speed/v.radius;
+
+			// Geodetic position
+			double lat = originLat + (north/EARTH_RADIUS)*180.0/M_PI;
+			double lon = originLon + (east/(EARTH_RADIUS*cos(originLat*M_PI/180.0)))*180.0/M_PI;
+
+			// Pack messages, with the vehicle's own sequence numbers so receivers see per-sysid sequences
+			mavlink_message_t msgs[SWARM_MAX_FRAMES];
+			int numMsgs = 0;
+			txStatus->current_tx_seq = v.seq;
+			mavlink_msg_global_position_int_pack(v.sysid, 1, &msgs[numMsgs++], timeBootMs, (int32_t)(lat*1e7), (int32_t)(lon*1e7),
+					(int32_t)((settings.origin[2] + alt)*1000.0), (int32_t)(alt*1000.0), (int16_t)(vNorth*100.0), (int16_t)(vEast*100.0),
+					(int16_t)(-climb*100.0), (uint16_t)(fmod(course*180.0/M_PI + 360.0, 360.0)*100.0));
+			mavlink_msg_attitude_pack(v.sysid, 1, &msgs[numMsgs++], timeBootMs, roll, pitch, course, 0.0, 0.0, yawRate);
+			mavlink_msg_vfr_hud_pack(v.sysid, 1, &msgs[numMsgs++], v.speed, v.speed, (int16_t)fmod(course*180.0/M_PI + 360.0, 360.0),
+					60, alt, climb);
+			if(heartbeat) {
+				mavlink_msg_heartbeat_pack(v.sysid, 1, &msgs[numMsgs++], MAV_TYPE_FIXED_WING, MAV_AUTOPILOT_ARDUPILOTMEGA,
+						MAV_MODE_FLAG_SAFETY_ARMED, 10, MAV_STATE_ACTIVE);
+			}
+			v.seq = txStatus->current_tx_seq;
+
+			// Serialise into this vehicle's block, one datagram per frame or all frames in one datagram
+			uint8_t* block = &frames[i*SWARM_MAX_FRAMES*MAVLINK_MAX_PACKET_LEN];
+			size_t used = 0;
+			for(int m=0; m<numMsgs; m++) {
+				uint16_t len = mavlink_msg_to_send_buffer(block + used, &msgs[m]);
+				if(!bundle || m == 0) {
+					iovecs[numDatagrams].iov_base = block + used;
+					iovecs[numDatagrams].iov_len = 0;
+					memset(&headers[numDatagrams], 0, sizeof(headers[numDatagrams]));
+					headers[numDatagrams].msg_hdr.msg_iov = &iovecs[numDatagrams];
+					headers[numDatagrams].msg_hdr.msg_iovlen = 1;
+					headers[numDatagrams].msg_hdr.msg_name = &v.destination;
+					headers[numDatagrams].msg_hdr.msg_namelen = sizeof(v.destination);
+					numDatagrams++;
+				}
+				iovecs[numDatagrams-1].iov_len += len;
+				used += len;
+			}
+			sentFrames += numMsgs;
+		}
+
+		// Send the tick with as few syscalls as possible
+		int sent = 0;
+		while(sent < numDatagrams) {
+			int n = sendmmsg(sock, &headers[sent], numDatagrams - sent, 0);
+			sendCalls++;
+			if(n <= 0) {
+				perror("sendmmsg");
+				break;
+			}
+			sent += n;
+		}
+		sentDatagrams += sent;
+
+		// Report rates
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double sinceReport = std::chrono::duration<double>(now - lastReport).count();
+		if(sinceReport > 5.0) {
+			printf("mavSwarm: %.0f frames/s, %.0f datagrams/s, %.0f sendmmsg/s\n",sentFrames/sinceReport,sentDatagrams/sinceReport,sendCalls/sinceReport);
+			sentFrames = 0;
+			sentDatagrams = 0;
+			sendCalls = 0;
+			lastReport = now;
+		}
+
+		// Wait for next tick, skipping ticks if we've fallen behind
+		nextTick += period;
+		if(nextTick < now) {
+			nextTick = now;
+		}
+		std::this_thread::sleep_until(nextTick);
+	}
+
+	close(sock);
+	return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * trafficLayer.cpp
+ */
+
+#include "trafficLayer.h"
+
+// Standard Includes
+#include <cmath>
+#include <algorithm>
+
+// Project Includes
+#include "mavAircraft.h"
+
+
+/* Constructor */
+TrafficLayer::TrafficLayer(trafficDef traffic, glm::dvec3 origin, PlaybackClock* clockPt) :
+		source(traffic.source, traffic.isFile, clockPt), model(traffic.filepath.c_str()) {
+	this->origin = origin;
+	this->ecefOrigin = MavAircraft::geo2ECEF(origin);
+
+	// Instance buffer sized for a full table, so it is never reallocated
+	instances.resize(table.capacity());
+	glGenBuffers(1,&instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER,instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER,instances.size()*sizeof(glm::vec4),NULL,GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+	model.setInstanceBuffer(instanceVBO,TRAFFIC_INSTANCE_LOCATION);
+}
+
+TrafficLayer::~TrafficLayer() {
+	source.stop();
+}
+
+/* Functions */
+void TrafficLayer::update(double currentTime) {
+	// Apply queued updates
+	TrafficUpdate update;
+	while(source.queue.pop(update)) {
+		int row = table.apply(update);
+		if(row >= 0 && (update.fields & (TRAFFIC_HAS_POSITION | TRAFFIC_HAS_ALTITUDE))) {
+			updateLocalPosition(row);
+		}
+	}
+
+	// Remove targets that have gone quiet
+	table.expire(currentTime, TRAFFIC_MAX_AGE);
+
+	// Dead reckon from the last position and pack the instances
+	const uint8_t needed = TRAFFIC_HAS_POSITION | TRAFFIC_HAS_ALTITUDE;
+	int n = 0;
+	for(int i=0; i<table.count; i++) {
+		if((table.fields[i] & needed) != needed) {
+			continue;
+		}
+		float dt = std::min(std::max(currentTime - table.timePosition[i], 0.0), TRAFFIC_DEAD_RECKON_LIMIT);
+		float speed = table.groundSpeed[i];
+		float track = table.track[i];
+		float north = table.north[i] + speed*cosf(track)*dt;
+		float east  = table.east[i]  + speed*sinf(track)*dt;
+		float up    = table.up[i]    + table.verticalRate[i]*dt;
+		instances[n++] = glm::vec4(north, up, east, track);
+	}
+	numDrawn = n;
+
+	// Upload only the live part of the buffer
+	if(n > 0) {
+		glBindBuffer(GL_ARRAY_BUFFER,instanceVBO);
+		glBufferSubData(GL_ARRAY_BUFFER,0,n*sizeof(glm::vec4),instances.data());
+		glBindBuffer(GL_ARRAY_BUFFER,0);
+	}
+}
+
+void TrafficLayer::Draw(Shader shader) {
+	if(numDrawn > 0) {
+		model.DrawInstanced(shader,numDrawn);
+	}
+}
+
+void TrafficLayer::updateLocalPosition(int row) {
+	// Converts the last reported position to NEU about the world origin. Altitude is MSL, so it is
+	// taken relative to the origin altitude to match the aircraft.
+	glm::dvec3 geoPosition = glm::dvec3(table.lat[row], table.lon[row], table.altitude[row] - origin[2]*1000.0);
+	glm::dvec3 pos = MavAircraft::ecef2NEU(MavAircraft::geo2ECEF(geoPosition), ecefOrigin, origin);
+	table.north[row] = pos[0];
+	table.east[row] = pos[1];
+	table.up[row] = pos[2];
+}
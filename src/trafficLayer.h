@@ -0,0 +1,61 @@
+/*
+ * trafficLayer.h
+ */
+
+#ifndef TRAFFICLAYER_H_
+#define TRAFFICLAYER_H_
+
+// Standard Includes
+#include <string>
+#include <vector>
+
+// GL Includes
+#include <GL/glew.h>
+
+// GLM Mathematics
+#include <glm/glm.hpp>
+
+// Project Includes
+#include "model.h"
+#include "shader.h"
+#include "settings.h"
+#include "trafficTable.h"
+#include "trafficSource.h"
+
+#define TRAFFIC_MAX_AGE				60.0		// Targets not heard from for this long are removed (s)
+#define TRAFFIC_DEAD_RECKON_LIMIT	10.0		// Longest extrapolation from the last position (s)
+#define TRAFFIC_INSTANCE_LOCATION	3			// Vertex attribute holding the per target data
+
+
+/* Classes */
+// Surrounding ADS-B traffic. Updates from the source thread are drained once per frame into the
+// traffic table, and every target is drawn with one instanced call of a single shared model.
+class TrafficLayer {
+public:
+	/* Data */
+	TrafficTable			table;
+	TrafficSource			source;
+	int						numDrawn = 0;
+
+	/* Constructor */
+	TrafficLayer(trafficDef traffic, glm::dvec3 origin, PlaybackClock* clockPt);
+	~TrafficLayer();
+
+	/* Functions */
+	void update(double currentTime);
+	void Draw(Shader shader);
+
+private:
+	/* Data */
+	Model					model;
+	glm::dvec3				origin;						// Lat (deg), Lon (deg), alt (km)
+	glm::dvec3				ecefOrigin;
+	std::vector<glm::vec4>	instances;					// (north, up, east, track) per drawn target
+	GLuint					instanceVBO;
+
+	/* Functions */
+	void updateLocalPosition(int row);
+};
+
+
+#endif /* TRAFFICLAYER_H_ */
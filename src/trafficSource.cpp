@@ -0,0 +1,321 @@
+/*
+ * trafficSource.cpp
+ */
+
+#include "trafficSource.h"
+
+// Standard Includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <cerrno>
+
+// Socket Includes
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+#define SBS_FIELDS				22			// Fields in a full MSG line
+#define SBS_POLL_MS				100			// Longest wait for data before checking for stop (ms)
+#define TRAFFIC_IDLE_SLEEP_MS	5			// Longest sleep while waiting for the next file line (ms)
+#define FEET_TO_METRES			0.3048
+#define KNOTS_TO_MS				0.514444
+
+
+/* Functions */
+// Non blocking connect, so an unreachable host can't hold up stop()
+static int connectSocket(const struct addrinfo* addr, const std::atomic<bool>& running) {
+	int fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+	if(fd < 0) {
+		return -1;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	if(connect(fd, addr->ai_addr, addr->ai_addrlen) != 0 && errno != EINPROGRESS) {
+		close(fd);
+		return -1;
+	}
+	for(int i=0; running && i < TRAFFIC_RECONNECT_PERIOD*1000/SBS_POLL_MS; i++) {
+		struct pollfd pfd = {fd, POLLOUT, 0};
+		if(poll(&pfd, 1, SBS_POLL_MS) > 0) {
+			int error = 0;
+			socklen_t errorLength = sizeof(error);
+			getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &errorLength);
+			if(error != 0) {
+				break;
+			}
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+			return fd;
+		}
+	}
+	close(fd);
+	return -1;
+}
+
+
+/* Constructor */
+TrafficSource::TrafficSource(std::string source, bool isFile, PlaybackClock* clockPt) : running(false) {
+	this->source = source;
+	this->isFile = isFile;
+	this->clockPt = clockPt;
+}
+
+TrafficSource::~TrafficSource() {
+	stop();
+}
+
+/* Functions */
+void TrafficSource::start() {
+	running = true;
+	if(isFile) {
+		readThread = std::thread(&TrafficSource::readFile, this);
+	} else {
+		readThread = std::thread(&TrafficSource::readSocket, this);
+	}
+}
+
+void TrafficSource::stop() {
+	if(running) {
+		running = false;
+		readThread.join();
+	}
+}
+
+void TrafficSource::readSocket() {
+	// Connects to host:port and keeps reconnecting while running
+	std::string host = source.substr(0, source.find_last_of(':'));
+	std::string port = source.substr(source.find_last_of(':') + 1);
+	char buffer[4*TRAFFIC_LINE_LENGTH];
+	while(running) {
+		// Resolve and connect
+		int fd = -1;
+		struct addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		struct addrinfo* result = NULL;
+		if(getaddrinfo(host.c_str(), port.c_str(), &hints, &result) == 0) {
+			for(struct addrinfo* addr = result; addr != NULL && fd < 0; addr = addr->ai_next) {
+				fd = connectSocket(addr, running);
+			}
+			freeaddrinfo(result);
+		}
+		if(fd < 0) {
+			// Wait before trying again, checking for stop
+			for(int i=0; running && i < TRAFFIC_RECONNECT_PERIOD*1000/SBS_POLL_MS; i++) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(SBS_POLL_MS));
+			}
+			continue;
+		}
+		printf("Traffic: connected to %s\n", source.c_str());
+		connected.set(true);
+
+		// Read lines until the connection drops
+		size_t used = 0;
+		bool skipping = false;						// Discarding the rest of an over length line
+		while(running) {
+			struct pollfd pfd = {fd, POLLIN, 0};
+			int ready = poll(&pfd, 1, SBS_POLL_MS);
+			if(ready == 0) {
+				continue;
+			}
+			ssize_t received = (ready > 0) ? recv(fd, buffer + used, sizeof(buffer) - used, 0) : -1;
+			if(received <= 0) {
+				break;
+			}
+			used += received;
+
+			// Pass on each complete line
+			double timeReceived = clockPt->now();
+			size_t start = 0;
+			for(size_t i=0; i<used; i++) {
+				if(buffer[i] == '\n') {
+					if(!skipping) {
+						processLine(buffer + start, i - start, timeReceived);
+					}
+					skipping = false;
+					start = i + 1;
+				}
+			}
+			used -= start;
+			memmove(buffer, buffer + start, used);
+			if(used == sizeof(buffer)) {
+				// No newline in a full buffer
+				skipping = true;
+				used = 0;
+				parseErrors.add();
+			}
+		}
+		close(fd);
+		connected.set(false);
+		if(running) {
+			printf("Traffic: lost connection to %s\n", source.c_str());
+		}
+	}
+}
+
+void TrafficSource::readFile() {
+	// Replays a recorded SBS stream, paced by the message times against the playback clock
+	FILE* file = fopen(source.c_str(), "r");
+	if(file == NULL) {
+		printf("ERROR: Could not open traffic file %s.\n", source.c_str());
+		return;
+	}
+	connected.set(true);
+	char line[TRAFFIC_LINE_LENGTH];
+	double timeStart = clockPt->now();
+	double firstTimeOfDay = -1;
+	double lastTimeOfDay = 0;
+	double dayOffset = 0;
+	TrafficUpdate update;
+	while(running && fgets(line, sizeof(line), file) != NULL) {
+		size_t length = strlen(line);
+		if(length == sizeof(line) - 1 && line[length - 1] != '\n') {
+			// Over length, skip to the end of the line
+			int c;
+			while((c = fgetc(file)) != EOF && c != '\n') {}
+			parseErrors.add();
+			continue;
+		}
+		lines.add();
+		double timeOfDay;
+		if(!parseSbsLine(line, length, &update, &timeOfDay)) {
+			parseErrors.add();
+			continue;
+		}
+
+		// Wait until the line is due
+		if(timeOfDay >= 0) {
+			if(firstTimeOfDay < 0) {
+				firstTimeOfDay = timeOfDay;
+			} else if(timeOfDay + dayOffset < lastTimeOfDay - 43200) {
+				// Past midnight
+				dayOffset += 86400;
+			}
+			lastTimeOfDay = timeOfDay + dayOffset;
+			update.timeReceived = timeStart + lastTimeOfDay - firstTimeOfDay;
+			while(running && clockPt->now() < update.timeReceived) {
+				double wait = (update.timeReceived - clockPt->now())/std::max(clockPt->getSpeed(), 1e-3);
+				int waitMs = std::min((int)(wait*1000.0), TRAFFIC_IDLE_SLEEP_MS);
+				std::this_thread::sleep_for(std::chrono::milliseconds(std::max(waitMs, 1)));
+			}
+		} else {
+			update.timeReceived = clockPt->now();
+		}
+		queue.push(update);
+	}
+	fclose(file);
+	printf("Traffic: end of %s, %lu lines\n", source.c_str(), (unsigned long)lines.get());
+}
+
+void TrafficSource::processLine(const char* line, size_t length, double timeReceived) {
+	// Decodes one line from the socket and queues it
+	lines.add();
+	TrafficUpdate update;
+	double timeOfDay;
+	if(!parseSbsLine(line, length, &update, &timeOfDay)) {
+		parseErrors.add();
+		return;
+	}
+	update.timeReceived = timeReceived;
+	queue.push(update);
+}
+
+bool parseSbsLine(const char* line, size_t length, TrafficUpdate* update, double* timeOfDay) {
+	// Decodes a BaseStation MSG line. Fields: 0 MSG, 1 type, 4 ICAO hex, 7 time generated, 10 callsign,
+	// 11 altitude (ft), 12 ground speed (kt), 13 track (deg), 14 lat, 15 lon, 16 vertical rate (ft/min),
+	// 21 on ground. Returns false for other lines, or lines with nothing usable.
+	char copy[TRAFFIC_LINE_LENGTH];
+	if(length >= sizeof(copy)) {
+		return false;
+	}
+	memcpy(copy, line, length);
+	copy[length] = '\0';
+
+	// Split in place
+	const char* field[SBS_FIELDS];
+	int numFields = 0;
+	char* pt = copy;
+	field[numFields++] = pt;
+	while(*pt != '\0' && numFields < SBS_FIELDS) {
+		if(*pt == ',') {
+			*pt = '\0';
+			field[numFields++] = pt + 1;
+		} else if(*pt == '\r' || *pt == '\n') {
+			*pt = '\0';
+			break;
+		}
+		pt++;
+	}
+	if(numFields < 5 || strcmp(field[0], "MSG") != 0) {
+		return false;
+	}
+
+	// Address
+	char* end;
+	unsigned long icao = strtoul(field[4], &end, 16);
+	if(end == field[4] || *end != '\0' || icao > 0xFFFFFF) {
+		return false;
+	}
+	update->icao = icao;
+	update->fields = 0;
+
+	// Message time
+	*timeOfDay = -1;
+	int hours, minutes;
+	double seconds;
+	if(numFields > 7 && sscanf(field[7], "%d:%d:%lf", &hours, &minutes, &seconds) == 3) {
+		*timeOfDay = hours*3600 + minutes*60 + seconds;
+	}
+
+	// Callsign, trimmed
+	if(numFields > 10 && field[10][0] != '\0') {
+		int n = 0;
+		for(const char* c = field[10]; *c != '\0' && n < TRAFFIC_CALLSIGN_LENGTH - 1; c++) {
+			if(*c != ' ') {
+				update->callsign[n++] = *c;
+			}
+		}
+		update->callsign[n] = '\0';
+		if(n > 0) {
+			update->fields |= TRAFFIC_HAS_CALLSIGN;
+		}
+	}
+
+	// Altitude
+	if(numFields > 11 && field[11][0] != '\0') {
+		update->altitude = atof(field[11]) * FEET_TO_METRES;
+		update->fields |= TRAFFIC_HAS_ALTITUDE;
+	}
+
+	// Velocity
+	if(numFields > 13 && field[12][0] != '\0' && field[13][0] != '\0') {
+		update->groundSpeed = atof(field[12]) * KNOTS_TO_MS;
+		update->track = atof(field[13]) * M_PI / 180.0;
+		update->verticalRate = (numFields > 16 && field[16][0] != '\0') ? atof(field[16]) * FEET_TO_METRES / 60.0 : 0;
+		update->fields |= TRAFFIC_HAS_VELOCITY;
+	}
+
+	// Position
+	if(numFields > 15 && field[14][0] != '\0' && field[15][0] != '\0') {
+		double lat = atof(field[14]);
+		double lon = atof(field[15]);
+		if(lat >= -90 && lat <= 90 && lon >= -180 && lon <= 180 && (lat != 0 || lon != 0)) {
+			update->lat = lat;
+			update->lon = lon;
+			update->fields |= TRAFFIC_HAS_POSITION;
+		}
+	}
+
+	// Surface flag, -1 means true in BaseStation output and empty means not reported
+	if(numFields > 21 && field[21][0] != '\0') {
+		update->fields |= TRAFFIC_HAS_GROUND;
+		if(strcmp(field[21], "-1") == 0 || strcmp(field[21], "1") == 0) {
+			update->fields |= TRAFFIC_ON_GROUND;
+		}
+	}
+	return update->fields != 0;
+}
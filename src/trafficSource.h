@@ -0,0 +1,65 @@
+/*
+ * trafficSource.h
+ */
+
+#ifndef TRAFFICSOURCE_H_
+#define TRAFFICSOURCE_H_
+
+// Standard Includes
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+// Project Includes
+#include "telemetryQueue.h"
+#include "trafficTable.h"
+#include "playbackClock.h"
+#include "linkHealth.h"
+
+#define TRAFFIC_QUEUE_LENGTH		8192		// Updates buffered between the reader and the render thread (power of two)
+#define TRAFFIC_LINE_LENGTH			512			// Longest SBS line kept, longer lines are dropped
+#define TRAFFIC_RECONNECT_PERIOD	5.0			// Time between connection attempts (s)
+
+typedef SpscQueue<TrafficUpdate, TRAFFIC_QUEUE_LENGTH> TrafficQueue;
+
+
+/* Classes */
+// Reads SBS-1 (BaseStation) messages, as served by dump1090 and most ADS-B receivers on TCP port
+// 30003, either live from a TCP socket or from a text file paced by the message times. Decoded
+// updates are queued for the render thread, which owns the traffic table.
+class TrafficSource {
+public:
+	/* Data */
+	std::string			source;					// host:port, or a file path
+	TrafficQueue		queue;
+	RelaxedCounter		lines;
+	RelaxedCounter		parseErrors;
+	RelaxedValue<bool>	connected;
+
+	/* Constructor */
+	TrafficSource(std::string source, bool isFile, PlaybackClock* clockPt);
+	~TrafficSource();
+
+	/* Functions */
+	void start();
+	void stop();
+
+private:
+	/* Data */
+	bool				isFile;
+	PlaybackClock*		clockPt;
+	std::atomic<bool>	running;
+	std::thread			readThread;
+
+	/* Functions */
+	void readSocket();
+	void readFile();
+	void processLine(const char* line, size_t length, double timeReceived);
+};
+
+/* Functions */
+bool parseSbsLine(const char* line, size_t length, TrafficUpdate* update, double* timeOfDay);
+
+
+#endif /* TRAFFICSOURCE_H_ */
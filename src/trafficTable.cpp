@@ -0,0 +1,194 @@
+/*
+ * trafficTable.cpp
+ */
+
+#include "trafficTable.h"
+
+// Standard Includes
+#include <cstring>
+
+#define TRAFFIC_HASH_EMPTY		0xFFFFFFFF		// ICAO addresses are 24 bit, so this never collides
+
+
+/* Constructor */
+TrafficTable::TrafficTable(int capacity) {
+	// Columns
+	icao.resize(capacity);
+	callsign.resize(capacity);
+	fields.resize(capacity);
+	lat.resize(capacity);
+	lon.resize(capacity);
+	altitude.resize(capacity);
+	groundSpeed.resize(capacity);
+	track.resize(capacity);
+	verticalRate.resize(capacity);
+	north.resize(capacity);
+	east.resize(capacity);
+	up.resize(capacity);
+	timePosition.resize(capacity);
+	timeSeen.resize(capacity);
+
+	// Hash at most half full, so probe runs stay short
+	uint32_t hashSize = 1;
+	while(hashSize < 2*(uint32_t)capacity) {
+		hashSize <<= 1;
+	}
+	hashKeys.assign(hashSize, TRAFFIC_HASH_EMPTY);
+	hashRows.assign(hashSize, -1);
+	hashMask = hashSize - 1;
+}
+
+/* Functions */
+int TrafficTable::find(uint32_t icao) {
+	// Row of a target, -1 if it isn't tracked
+	uint32_t i = hashIndex(icao);
+	while(hashKeys[i] != TRAFFIC_HASH_EMPTY) {
+		if(hashKeys[i] == icao) {
+			return hashRows[i];
+		}
+		i = (i + 1) & hashMask;
+	}
+	return -1;
+}
+
+int TrafficTable::apply(const TrafficUpdate& update) {
+	// Merges an update into its target's row, adding the target if new. Returns the row, -1 if full.
+	int row = find(update.icao);
+	if(row < 0) {
+		if(count >= capacity()) {
+			return -1;
+		}
+		row = count++;
+		icao[row] = update.icao;
+		callsign[row].name[0] = '\0';
+		fields[row] = 0;
+		lat[row] = 0;
+		lon[row] = 0;
+		altitude[row] = 0;
+		groundSpeed[row] = 0;
+		track[row] = 0;
+		verticalRate[row] = 0;
+		north[row] = 0;
+		east[row] = 0;
+		up[row] = 0;
+		timePosition[row] = update.timeReceived;
+		hashInsert(update.icao, row);
+	}
+
+	// Copy the fields carried
+	if(update.fields & TRAFFIC_HAS_CALLSIGN) {
+		memcpy(callsign[row].name, update.callsign, TRAFFIC_CALLSIGN_LENGTH);
+	}
+	if(update.fields & TRAFFIC_HAS_POSITION) {
+		lat[row] = update.lat;
+		lon[row] = update.lon;
+		timePosition[row] = update.timeReceived;
+	}
+	if(update.fields & TRAFFIC_HAS_ALTITUDE) {
+		altitude[row] = update.altitude;
+	}
+	if(update.fields & TRAFFIC_HAS_VELOCITY) {
+		groundSpeed[row] = update.groundSpeed;
+		track[row] = update.track;
+		verticalRate[row] = update.verticalRate;
+	}
+	// Most reports leave the surface flag out, so only those carrying it change it
+	uint8_t kept = (update.fields & TRAFFIC_HAS_GROUND) ? (fields[row] & ~TRAFFIC_ON_GROUND) : fields[row];
+	fields[row] = kept | update.fields;
+	timeSeen[row] = update.timeReceived;
+	return row;
+}
+
+int TrafficTable::expire(double currentTime, double maxAge) {
+	// Removes targets not heard from for maxAge, returns the number removed
+	int removed = 0;
+	int row = 0;
+	while(row < count) {
+		if(currentTime - timeSeen[row] > maxAge) {
+			// The last row moves here, so check this row again
+			removeRow(row);
+			removed++;
+		} else {
+			row++;
+		}
+	}
+	return removed;
+}
+
+int TrafficTable::capacity() {
+	return icao.size();
+}
+
+uint32_t TrafficTable::hashIndex(uint32_t key) {
+	// Multiplicative hash, ICAO blocks are allocated sequentially per country
+	return (key * 2654435761u) & hashMask;
+}
+
+void TrafficTable::hashInsert(uint32_t key, int row) {
+	uint32_t i = hashIndex(key);
+	while(hashKeys[i] != TRAFFIC_HASH_EMPTY) {
+		i = (i + 1) & hashMask;
+	}
+	hashKeys[i] = key;
+	hashRows[i] = row;
+}
+
+void TrafficTable::hashSet(uint32_t key, int row) {
+	// Points an existing key at a new row
+	uint32_t i = hashIndex(key);
+	while(hashKeys[i] != key) {
+		i = (i + 1) & hashMask;
+	}
+	hashRows[i] = row;
+}
+
+void TrafficTable::hashErase(uint32_t key) {
+	// Removes a key and shifts later entries of the probe run back, so no tombstones build up
+	uint32_t i = hashIndex(key);
+	while(hashKeys[i] != key) {
+		if(hashKeys[i] == TRAFFIC_HASH_EMPTY) {
+			return;
+		}
+		i = (i + 1) & hashMask;
+	}
+	uint32_t j = i;
+	while(true) {
+		j = (j + 1) & hashMask;
+		if(hashKeys[j] == TRAFFIC_HASH_EMPTY) {
+			break;
+		}
+		// Move the entry at j into the hole at i if its home slot isn't in (i, j]
+		uint32_t home = hashIndex(hashKeys[j]);
+		if(((j - home) & hashMask) >= ((j - i) & hashMask)) {
+			hashKeys[i] = hashKeys[j];
+			hashRows[i] = hashRows[j];
+			i = j;
+		}
+	}
+	hashKeys[i] = TRAFFIC_HASH_EMPTY;
+	hashRows[i] = -1;
+}
+
+void TrafficTable::removeRow(int row) {
+	// Swap the last row into the removed one to keep the columns packed
+	hashErase(icao[row]);
+	int last = count - 1;
+	if(row != last) {
+		icao[row] = icao[last];
+		callsign[row] = callsign[last];
+		fields[row] = fields[last];
+		lat[row] = lat[last];
+		lon[row] = lon[last];
+		altitude[row] = altitude[last];
+		groundSpeed[row] = groundSpeed[last];
+		track[row] = track[last];
+		verticalRate[row] = verticalRate[last];
+		north[row] = north[last];
+		east[row] = east[last];
+		up[row] = up[last];
+		timePosition[row] = timePosition[last];
+		timeSeen[row] = timeSeen[last];
+		hashSet(icao[row], row);
+	}
+	count--;
+}
@@ -0,0 +1,91 @@
+/*
+ * trafficTable.h
+ */
+
+#ifndef TRAFFICTABLE_H_
+#define TRAFFICTABLE_H_
+
+// Standard Includes
+#include <cstdint>
+#include <vector>
+
+#define TRAFFIC_MAX_TARGETS		8192		// Targets tracked at once, new targets are ignored while full
+#define TRAFFIC_CALLSIGN_LENGTH	9			// 8 characters and a terminator
+
+// Fields carried by an update
+#define TRAFFIC_HAS_CALLSIGN	(1 << 0)
+#define TRAFFIC_HAS_POSITION	(1 << 1)
+#define TRAFFIC_HAS_ALTITUDE	(1 << 2)
+#define TRAFFIC_HAS_VELOCITY	(1 << 3)
+#define TRAFFIC_ON_GROUND		(1 << 4)			// Valid with TRAFFIC_HAS_GROUND
+#define TRAFFIC_HAS_GROUND		(1 << 5)			// The update says whether the target is on the ground
+
+
+/* Structures */
+// One decoded report about one target, only the fields flagged are valid
+struct TrafficUpdate {
+	uint32_t	icao;								// 24 bit ICAO aircraft address
+	uint8_t		fields;								// TRAFFIC_HAS_ flags
+	char		callsign[TRAFFIC_CALLSIGN_LENGTH];
+	double		lat;								// (deg)
+	double		lon;								// (deg)
+	float		altitude;							// Barometric, MSL (m)
+	float		groundSpeed;						// (m/s)
+	float		track;								// True track (rad)
+	float		verticalRate;						// (m/s)
+	double		timeReceived;						// Playback clock time (s)
+};
+
+struct TrafficCallsign {
+	char		name[TRAFFIC_CALLSIGN_LENGTH];
+};
+
+/* Classes */
+// State of every surrounding target, stored column by column so per frame passes (expiry, dead
+// reckoning, building the instance buffer) stream through only the fields they use. Live targets
+// are packed into [0, count); removing one moves the last into its place. An open addressing hash
+// maps ICAO addresses to rows. Everything is allocated once up front and owned by the render thread.
+class TrafficTable {
+public:
+	/* Data */
+	int							count = 0;
+	std::vector<uint32_t>		icao;
+	std::vector<TrafficCallsign> callsign;
+	std::vector<uint8_t>		fields;				// TRAFFIC_HAS_ flags seen so far
+	std::vector<double>			lat;
+	std::vector<double>			lon;
+	std::vector<float>			altitude;
+	std::vector<float>			groundSpeed;
+	std::vector<float>			track;
+	std::vector<float>			verticalRate;
+	std::vector<float>			north;				// Position relative to the world origin (m), set by the owner
+	std::vector<float>			east;
+	std::vector<float>			up;
+	std::vector<double>			timePosition;		// Time of the last position (s)
+	std::vector<double>			timeSeen;			// Time of the last message of any kind (s)
+
+	/* Constructor */
+	TrafficTable(int capacity = TRAFFIC_MAX_TARGETS);
+
+	/* Functions */
+	int find(uint32_t icao);
+	int apply(const TrafficUpdate& update);
+	int expire(double currentTime, double maxAge);
+	int capacity();
+
+private:
+	/* Data */
+	std::vector<uint32_t>		hashKeys;			// ICAO address, or TRAFFIC_HASH_EMPTY
+	std::vector<int32_t>		hashRows;
+	uint32_t					hashMask;
+
+	/* Functions */
+	uint32_t hashIndex(uint32_t key);
+	void hashInsert(uint32_t key, int row);
+	void hashSet(uint32_t key, int row);
+	void hashErase(uint32_t key);
+	void removeRow(int row);
+};
+
+
+#endif /* TRAFFICTABLE_H_ */
@@ -0,0 +1,65 @@
+/*
+ * vehiclePool.cpp
+ */
+
+#include "vehiclePool.h"
+
+
+/* Constructor */
+VehiclePool::VehiclePool(int numSlots) : slots(new VehicleSlot[numSlots]) {
+	this->numSlots = numSlots;
+	for(int i=0; i<numSlots; i++) {
+		slots[i].status.store(VEHICLE_SLOT_FREE, std::memory_order_relaxed);
+		slots[i].sysid = 0;
+		slots[i].lastSeen.set(0);
+		slots[i].channelPt = nullptr;
+	}
+}
+
+/* Functions */
+int VehiclePool::size() {
+	return numSlots;
+}
+
+VehicleSlot* VehiclePool::slot(int i) {
+	return &slots[i];
+}
+
+void VehiclePool::setChannel(int i, TelemetryChannel* channelPt) {
+	// Binds a slot to its aircraft's channel, before the links start
+	slots[i].channelPt = channelPt;
+}
+
+VehicleSlot* VehiclePool::claim(uint8_t sysid, double currentTime) {
+	// Takes a free slot for a new vehicle, nullptr if the pool is full
+	for(int i=0; i<numSlots; i++) {
+		if(slots[i].status.load(std::memory_order_acquire) != VEHICLE_SLOT_FREE) {
+			continue;
+		}
+		// Fill in the slot before publishing it to the render thread
+		slots[i].sysid = sysid;
+		slots[i].lastSeen.set(currentTime);
+		slots[i].status.store(VEHICLE_SLOT_ACTIVE, std::memory_order_release);
+		claimed.add();
+		return &slots[i];
+	}
+	refused.add();
+	return nullptr;
+}
+
+bool VehiclePool::acknowledge(VehicleSlot* slotPt) {
+	// Confirms a slot being retired will get no more writes, true if it was being retired
+	int expected = VEHICLE_SLOT_RETIRING;
+	return slotPt->status.compare_exchange_strong(expected, VEHICLE_SLOT_RETIRED, std::memory_order_acq_rel);
+}
+
+bool VehiclePool::retire(VehicleSlot* slotPt) {
+	// Asks the ingest thread to stop routing to a silent slot, true if it was active
+	int expected = VEHICLE_SLOT_ACTIVE;
+	return slotPt->status.compare_exchange_strong(expected, VEHICLE_SLOT_RETIRING, std::memory_order_acq_rel);
+}
+
+void VehiclePool::release(VehicleSlot* slotPt) {
+	// Returns a retired slot, once its channel has been drained and cleared
+	slotPt->status.store(VEHICLE_SLOT_FREE, std::memory_order_release);
+}
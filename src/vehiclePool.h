@@ -0,0 +1,74 @@
+/*
+ * vehiclePool.h
+ */
+
+#ifndef VEHICLEPOOL_H_
+#define VEHICLEPOOL_H_
+
+// Standard Includes
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+// Project Includes
+#include "telemetryState.h"
+#include "linkHealth.h"
+
+#define VEHICLE_SILENT_TIMEOUT		10.0		// Discovered vehicles not heard from for this long are retired (s)
+#define VEHICLE_SWEEP_PERIOD		1.0			// Time between ingest checks for slots being retired (s)
+
+
+/* Structures */
+// Slot hand over between the ingest thread (I) and the render thread (R):
+// FREE -(I claims for a new sysid)-> ACTIVE -(R finds it silent)-> RETIRING -(I drops the route)-> RETIRED
+// -(R drains and clears the channel)-> FREE. Only the ingest thread writes the channel while ACTIVE or
+// RETIRING, and only the render thread touches it while RETIRED or FREE.
+enum VehicleSlotStatus {
+	VEHICLE_SLOT_FREE,
+	VEHICLE_SLOT_ACTIVE,
+	VEHICLE_SLOT_RETIRING,
+	VEHICLE_SLOT_RETIRED
+};
+
+struct VehicleSlot {
+	std::atomic<int>		status;
+	uint8_t					sysid;					// Set by the ingest thread before the slot goes ACTIVE
+	RelaxedValue<double>	lastSeen;				// Time of the last message from the vehicle (s)
+	TelemetryChannel*		channelPt;				// Channel of the aircraft drawing this slot
+};
+
+/* Classes */
+// Fixed set of aircraft slots for vehicles that appear on a link without being in the config. The
+// slots and their aircraft are allocated up front, so a new vehicle costs no allocation or model load,
+// and the number of vehicles drawn is bounded by the pool size.
+class VehiclePool {
+public:
+	/* Data */
+	RelaxedCounter	claimed;						// Vehicles given a slot
+	RelaxedCounter	refused;						// New vehicles seen while every slot was taken
+	RelaxedValue<double>	lastIngest;				// Time of the newest message on the pool's links (s)
+
+	/* Constructor */
+	VehiclePool(int numSlots);
+
+	/* Functions */
+	int size();
+	VehicleSlot* slot(int i);
+	void setChannel(int i, TelemetryChannel* channelPt);
+
+	// Ingest thread
+	VehicleSlot* claim(uint8_t sysid, double currentTime);
+	bool acknowledge(VehicleSlot* slotPt);
+
+	// Render thread
+	bool retire(VehicleSlot* slotPt);
+	void release(VehicleSlot* slotPt);
+
+private:
+	/* Data */
+	int								numSlots;
+	std::unique_ptr<VehicleSlot[]>	slots;
+};
+
+
+#endif /* VEHICLEPOOL_H_ */
@@ -108,18 +108,48 @@ void key_callback(GLFWwindow* window,int key,int scancode, int action, int mode)
 				camera.otherAircraftID = 0;
 			}
 		}
-		// Change Aircraft Forward
+		// Change Aircraft Forward, skipping empty discovery slots
 		if(key==GLFW_KEY_Z) {
-			camera.aircraftID += 1;
-			if (camera.aircraftID > (int)camera.mavAircraftListPt->size() - 1) {
-				camera.aircraftID = 0;
+			int numAircraft = camera.mavAircraftListPt->size();
+			for(int i=0; i<numAircraft; i++) {
+				camera.aircraftID += 1;
+				if (camera.aircraftID > numAircraft - 1) {
+					camera.aircraftID = 0;
+				}
+				if((*camera.mavAircraftListPt)[camera.aircraftID].active) {
+					break;
+				}
 			}
 		}
-		// Change Aircraft Backward
+		// Change Aircraft Backward, skipping empty discovery slots
 		if(key==GLFW_KEY_X) {
-			camera.aircraftID -= 1;
-			if (camera.aircraftID < 0) {
-				camera.aircraftID = camera.mavAircraftListPt->size() - 1 ;
+			int numAircraft = camera.mavAircraftListPt->size();
+			for(int i=0; i<numAircraft; i++) {
+				camera.aircraftID -= 1;
+				if (camera.aircraftID < 0) {
+					camera.aircraftID = numAircraft - 1;
+				}
+				if((*camera.mavAircraftListPt)[camera.aircraftID].active) {
+					break;
+				}
+			}
+		}
+		// Replay Controls
+		if(!playbackClock.isLive()) {
+			if(key==GLFW_KEY_SPACE) {
+				playbackClock.togglePause();
+			}
+			if(key==GLFW_KEY_LEFT) {
+				playbackClock.seek(-10.0);
+			}
+			if(key==GLFW_KEY_RIGHT) {
+				playbackClock.seek(10.0);
+			}
+			if(key==GLFW_KEY_UP && !playbackClock.asFastAsPossible()) {
+				playbackClock.setSpeed(playbackClock.getSpeed()*2.0);
+			}
+			if(key==GLFW_KEY_DOWN && !playbackClock.asFastAsPossible()) {
+				playbackClock.setSpeed(playbackClock.getSpeed()/2.0);
 			}
 		}
 	} else if (action == GLFW_RELEASE) {
@@ -18,6 +18,7 @@
 // openGL Includes
 #include "camera.h"
 #include "settings.h"
+#include "playbackClock.h"
 
 
 /* Camera and Screen Setup */